@@ -0,0 +1,41 @@
+// libFuzzer target: feeds arbitrary bytes to the decoders, which have to either decode them or throw
+// std::runtime_error, never crash or read out of bounds.
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "../src/coder/chunk_walker.hpp"
+#include "../src/coder/container.hpp"
+#include "../src/coder/decoder.hpp"
+#include "../src/coder/member_decoder.hpp"
+#include "../src/coder/member_frame.hpp"
+#include "../src/coder/stream_decoder.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  try {
+    if (container::has_header(data, size)) {
+      const container::mode coding_mode = container::read_mode(data);
+      if (coding_mode == container::mode::member) {
+        member_decoder decoder(2);
+        std::vector<uint8_t> decoded_data;
+        for (const member_frame::member& m : member_frame::find_members(data, size)) {
+          decoded_data.clear();
+          decoder.decode(data + m.offset, m.size, decoded_data);
+        }
+      } else if (coding_mode == container::mode::stream) {
+        stream_decoder decoder(4);
+        std::vector<uint8_t> decoded_data;
+        decoder.decode(data + container::HEADER_SIZE, size - container::HEADER_SIZE, decoded_data);
+      } else {
+        std::vector<uint8_t> decoded_data;
+        chunk_walker::decode(data, size, decoded_data);
+      }
+    } else {
+      decoder basic_decoder;
+      basic_decoder.decode_data(std::vector<uint8_t>(data, data + size));
+    }
+  } catch (const std::runtime_error&) {
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+// libFuzzer target: every coding mode has to reproduce arbitrary input exactly.
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "../src/coder/adaptive_encoder.hpp"
+#include "../src/coder/block_encoder.hpp"
+#include "../src/coder/block_planner.hpp"
+#include "../src/coder/chunk_walker.hpp"
+#include "../src/coder/container.hpp"
+#include "../src/coder/decoder.hpp"
+#include "../src/coder/encoder.hpp"
+#include "../src/coder/stream_decoder.hpp"
+#include "../src/coder/stream_encoder.hpp"
+#include "../src/huffman/huffman.hpp"
+
+namespace {
+
+void check(bool condition) {
+  if (!condition) std::abort();
+}
+
+std::vector<uint8_t> decode_chunks(const std::vector<uint8_t>& encoded_data) {
+  std::vector<uint8_t> decoded_data;
+  chunk_walker::decode(encoded_data.data(), encoded_data.size(), decoded_data);
+  return decoded_data;
+}
+
+std::vector<uint8_t> encode_chunks(chunk_encoder& coder, const std::vector<uint8_t>& data, size_t chunk_size) {
+  std::vector<uint8_t> encoded_data;
+  coder.encode_header(encoded_data);
+  for (size_t offset = 0; offset < data.size(); offset += chunk_size) {
+    coder.encode_chunk(data.data() + offset, std::min(chunk_size, data.size() - offset), encoded_data);
+  }
+  coder.encode_end(encoded_data);
+  return encoded_data;
+}
+
+std::vector<uint8_t> round_trip_blocks(block_encoder& coder, const std::vector<uint8_t>& data,
+                                       const std::vector<size_t>& block_sizes) {
+  std::vector<uint8_t> encoded_data;
+  coder.encode_header(encoded_data);
+  coder.encode_blocks(data.data(), block_sizes, 3, encoded_data);
+  coder.encode_end(encoded_data);
+  return decode_chunks(encoded_data);
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size == 0) return 0;
+  const std::vector<uint8_t> input(data, data + size);
+
+  huffman algorithm;
+  algorithm.initialize_data(input);
+  algorithm.calculate_frequencies();
+  algorithm.sort_frequencies();
+  algorithm.build_tree();
+  algorithm.compile_codebook();
+  encoder basic_encoder;
+  decoder basic_decoder;
+  check(basic_decoder.decode_data(basic_encoder.encode_data_with_codebook(input, algorithm.get_codebook())) == input);
+
+  // The first byte picks a chunk size, so that chunk boundaries move around.
+  const size_t chunk_size = 1u + data[0] % 64u;
+  adaptive_encoder adaptive_encoding;
+  const std::vector<uint8_t> adaptive_data = encode_chunks(adaptive_encoding, input, chunk_size);
+  check(decode_chunks(adaptive_data) == input);
+
+  block_encoder block_encoding(data[0] % 8u);
+  const std::vector<uint8_t> block_data = encode_chunks(block_encoding, input, chunk_size);
+  check(decode_chunks(block_data) == input);
+
+  // Appended streams decode to the concatenation of their inputs
+  std::vector<uint8_t> appended_data = adaptive_data;
+  appended_data.insert(appended_data.end(), block_data.begin(), block_data.end());
+  std::vector<uint8_t> appended_input = input;
+  appended_input.insert(appended_input.end(), input.begin(), input.end());
+  check(decode_chunks(appended_data) == appended_input);
+
+  // Settings of the fastest level: sampled histograms and short codes, plus checksums
+  block_encoder sampled_block_encoding(data[0] % 8u, 11, 1u + data[0] % 4u, true);
+  check(decode_chunks(encode_chunks(sampled_block_encoding, input, chunk_size)) == input);
+
+  // Blocks encoded in parallel, cut every chunk_size bytes and as planned
+  std::vector<size_t> block_sizes;
+  for (size_t offset = 0; offset < input.size(); offset += chunk_size) {
+    block_sizes.push_back(std::min(chunk_size, input.size() - offset));
+  }
+  block_encoder parallel_block_encoding(data[0] % 8u);
+  check(round_trip_blocks(parallel_block_encoding, input, block_sizes) == input);
+  block_encoder planned_block_encoding(0);
+  check(round_trip_blocks(planned_block_encoding, input,
+                          block_planner(block_planner::SEGMENT_SIZE).plan(input.data(), input.size(), 3)) == input);
+
+  stream_encoder stream_encoding(1);
+  stream_decoder stream_decoding(4);
+  std::vector<uint8_t> encoded_stream;
+  std::vector<uint8_t> decoded_stream;
+  stream_encoding.encode(input.data(), input.size(), encoded_stream);
+  stream_decoding.decode(encoded_stream.data() + container::HEADER_SIZE, encoded_stream.size() - container::HEADER_SIZE,
+                         decoded_stream);
+  check(decoded_stream == input);
+  return 0;
+}
@@ -0,0 +1,521 @@
+// Release gate: round-trips a deterministic corpus through the huffman executable in every coding mode, checks that
+// the output matches the input byte for byte, and compares throughput and peak RSS with stored baselines.
+#include <fmt/core.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+namespace {
+
+// Throughput is only compared for inputs at least this large, smaller runs are dominated by process startup
+constexpr uint64_t MIN_TIMED_SIZE = 16u << 20;
+// A timed run is repeated until the repetitions have taken this long together, and its time is their average, so
+// that runs of tens of milliseconds aren't at the mercy of scheduling and startup noise
+constexpr double MIN_SAMPLE_SECONDS = 0.5;
+// Peak RSS may exceed its baseline by this much on top of the relative tolerance (allocator and loader noise)
+constexpr double RSS_SLACK_MIB = 1.0;
+constexpr size_t WRITE_BUFFER_SIZE = 1u << 20;
+
+// splitmix64: tiny, fast and the same on every platform, so the corpus is identical wherever it's generated
+class random_source {
+ public:
+  explicit random_source(uint64_t seed) : m_state(seed) {}
+
+  uint64_t next() {
+    uint64_t z = (m_state += 0x9E3779B97F4A7C15u);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t below(uint64_t bound) { return next() % bound; }
+
+ private:
+  uint64_t m_state;
+};
+
+using generator = std::function<void(uint64_t size, random_source& random, std::vector<uint8_t>& out)>;
+
+struct corpus_entry {
+  std::string name;
+  // Size at scale 1; sizes of at most 4 KiB are edge cases and don't scale
+  uint64_t size;
+  generator generate;
+  std::vector<std::string> modes;
+};
+
+struct measurement {
+  double compress_mb_s;
+  double decompress_mb_s;
+  double compress_rss_mib;
+  double decompress_rss_mib;
+};
+
+struct run_result {
+  double seconds;
+  double peak_rss_mib;
+};
+
+const std::map<std::string, std::vector<std::string>> MODE_OPTIONS = {
+    {"basic", {}},
+    {"adaptive", {"--adaptive"}},
+    {"block-256", {"--block-size", "256"}},
+    {"fastest", {"--level", "fastest"}},
+    {"balanced", {"--level", "balanced"}},
+    {"best", {"--level", "best"}},
+    {"sync-1024", {"--sync-interval", "1024"}},
+};
+const std::vector<std::string> ALL_MODES = {"basic",    "adaptive", "block-256", "fastest",
+                                            "balanced", "best",     "sync-1024"};
+
+void generate_single_symbol(uint64_t size, random_source&, std::vector<uint8_t>& out) { out.assign(size, 'a'); }
+
+// Two symbols get one-bit codes, so an input of n bytes leaves 8 - n % 8 bits of padding in the last byte
+void generate_two_symbols(uint64_t size, random_source& random, std::vector<uint8_t>& out) {
+  out.resize(size);
+  for (auto& byte : out) byte = random.below(2) ? 'b' : 'a';
+}
+
+void generate_byte_ramp(uint64_t size, random_source&, std::vector<uint8_t>& out) {
+  out.resize(size);
+  for (size_t i = 0; i < out.size(); ++i) out[i] = static_cast<uint8_t>(i);
+}
+
+void generate_uniform(uint64_t size, random_source& random, std::vector<uint8_t>& out) {
+  out.resize(size);
+  size_t i = 0;
+  for (; i + 8 <= out.size(); i += 8) {
+    const uint64_t value = random.next();
+    for (size_t j = 0; j < 8; ++j) out[i + j] = static_cast<uint8_t>(value >> (8 * j));
+  }
+  for (; i < out.size(); ++i) out[i] = static_cast<uint8_t>(random.next());
+}
+
+// Byte k occurs fib(k) times: the most skewed histogram there is, which makes the Huffman tree as deep as the size
+// allows (codes of about 40 bits at 256 MiB), far beyond the length limit of the block coders
+void generate_fibonacci(uint64_t size, random_source& random, std::vector<uint8_t>& out) {
+  out.clear();
+  out.reserve(size);
+  uint64_t previous = 1;
+  uint64_t current = 1;
+  uint8_t symbol = 0;
+  for (; symbol < 255 && out.size() + current <= size; ++symbol) {
+    out.insert(out.end(), current, symbol);
+    const uint64_t next = previous + current;
+    previous = current;
+    current = next;
+  }
+  // The rest goes to the most frequent byte, which keeps the tree just as deep
+  out.resize(size, static_cast<uint8_t>(symbol - 1u));
+  for (size_t i = out.size(); i > 1; --i) std::swap(out[i - 1], out[random.below(i)]);
+}
+
+void append_text(uint64_t size, random_source& random, std::vector<uint8_t>& out) {
+  static const std::array<const char*, 32> words = {
+      "the",   "of",     "and",     "to",     "in",      "a",       "is",     "that",
+      "for",   "it",     "as",      "was",    "with",    "be",      "by",     "on",
+      "not",   "he",     "this",    "are",    "or",      "his",     "from",   "at",
+      "which", "but",    "have",    "an",     "had",     "they",    "you",    "were"};
+  const size_t end = out.size() + size;
+  while (out.size() < end) {
+    // Squaring the uniform index favours the first words, roughly like word frequencies in English
+    const uint64_t r = random.below(32u * 32u);
+    const char* word = words[r * r / (32u * 32u * 32u)];
+    for (const char* c = word; *c != '\0' && out.size() < end; ++c) out.push_back(static_cast<uint8_t>(*c));
+    if (out.size() < end) out.push_back(random.below(12) == 0 ? '\n' : ' ');
+  }
+}
+
+void generate_text(uint64_t size, random_source& random, std::vector<uint8_t>& out) {
+  out.clear();
+  out.reserve(size);
+  append_text(size, random, out);
+}
+
+// Segments of text, random bytes, runs and a small alphabet, 64 KiB to 4 MiB each: what block planning is for
+void generate_mixed(uint64_t size, random_source& random, std::vector<uint8_t>& out) {
+  out.clear();
+  out.reserve(size);
+  std::vector<uint8_t> segment;
+  while (out.size() < size) {
+    const uint64_t length = std::min<uint64_t>((64u << 10) + random.below(4u << 20), size - out.size());
+    switch (random.below(4)) {
+      case 0:
+        append_text(length, random, out);
+        continue;
+      case 1:
+        generate_uniform(length, random, segment);
+        break;
+      case 2:
+        segment.assign(length, static_cast<uint8_t>(random.next()));
+        break;
+      default:
+        segment.resize(length);
+        for (auto& byte : segment) byte = static_cast<uint8_t>('0' + random.below(10));
+        break;
+    }
+    out.insert(out.end(), segment.begin(), segment.end());
+  }
+}
+
+std::vector<corpus_entry> compile_corpus() {
+  std::vector<corpus_entry> corpus = {
+      {"single_byte", 1, generate_single_symbol, ALL_MODES},
+      {"byte_ramp", 256, generate_byte_ramp, ALL_MODES},
+      {"single_symbol", 512u << 20, generate_single_symbol, ALL_MODES},
+      {"uniform", 768u << 20, generate_uniform, ALL_MODES},
+      {"fibonacci", 256u << 20, generate_fibonacci, ALL_MODES},
+      {"text", 1024u << 20, generate_text, ALL_MODES},
+      {"mixed", 512u << 20, generate_mixed, {"basic", "block-256", "balanced", "best"}},
+  };
+  for (uint64_t size = 1; size <= 9; ++size) {
+    corpus.push_back({fmt::format("padding_{}", size), size, generate_two_symbols, {"basic", "adaptive", "best"}});
+  }
+  return corpus;
+}
+
+// FNV-1a, since std::hash differs between standard libraries
+uint64_t seed(const std::string& name) {
+  uint64_t hash = 0xCBF29CE484222325u;
+  for (const char c : name) hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3u;
+  return hash;
+}
+
+uint64_t scaled_size(const corpus_entry& entry, double scale) {
+  if (entry.size <= 4096) return entry.size;
+  return std::max<uint64_t>(static_cast<uint64_t>(static_cast<double>(entry.size) * scale), 4097u);
+}
+
+// Inputs are cached across runs: the corpus is deterministic, so a file of the right size is the right file. They're
+// generated in a child process: a child's peak RSS starts from its parent's (Linux carries it over fork and exec), so
+// the parent has to stay small for the measurements of the huffman runs to mean anything.
+void prepare_input(const corpus_entry& entry, uint64_t size, const fs::path& path) {
+  if (fs::exists(path) && fs::file_size(path) == size) return;
+  std::cout << fmt::format("Generating {} ({} bytes)...", entry.name, size) << std::endl;
+  const pid_t pid = fork();
+  if (pid < 0) throw std::runtime_error("Error: fork failed");
+  if (pid == 0) {
+    random_source random(seed(entry.name) ^ size);
+    std::vector<uint8_t> data;
+    entry.generate(size, random, data);
+    std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+    for (size_t offset = 0; offset < data.size(); offset += WRITE_BUFFER_SIZE) {
+      file.write(reinterpret_cast<const char*>(data.data() + offset),
+                 static_cast<std::streamsize>(std::min(WRITE_BUFFER_SIZE, data.size() - offset)));
+    }
+    file.close();
+    _exit(file ? 0 : 1);
+  }
+  int status = 0;
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    throw std::runtime_error(fmt::format("Error: couldn't generate {}", path.string()));
+  }
+}
+
+// Runs the program to completion with stdout in a log file; peak RSS comes from the kernel's accounting of the child
+run_result run(const std::vector<std::string>& arguments, const fs::path& log) {
+  std::vector<char*> argv;
+  for (const auto& argument : arguments) argv.push_back(const_cast<char*>(argument.c_str()));
+  argv.push_back(nullptr);
+  const auto start = std::chrono::steady_clock::now();
+  const pid_t pid = fork();
+  if (pid < 0) throw std::runtime_error("Error: fork failed");
+  if (pid == 0) {
+    if (std::freopen(log.string().c_str(), "w", stdout) == nullptr) _exit(127);
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+  int status = 0;
+  rusage usage{};
+  if (wait4(pid, &status, 0, &usage) != pid) throw std::runtime_error("Error: wait4 failed");
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    throw std::runtime_error(fmt::format("Error: {} exited abnormally (status {})", arguments[0], status));
+  }
+  return {elapsed.count(), static_cast<double>(usage.ru_maxrss) / 1024.0};
+}
+
+// Runs the program as often as needed to fill MIN_SAMPLE_SECONDS, removing its output before every run; returns the
+// average time and the highest peak RSS
+run_result run_sample(const std::vector<std::string>& arguments, const fs::path& output, const fs::path& log) {
+  run_result sample{0.0, 0.0};
+  unsigned runs = 0;
+  do {
+    fs::remove(output);
+    const run_result next = run(arguments, log);
+    sample.seconds += next.seconds;
+    sample.peak_rss_mib = std::max(sample.peak_rss_mib, next.peak_rss_mib);
+    ++runs;
+  } while (sample.seconds < MIN_SAMPLE_SECONDS);
+  sample.seconds /= runs;
+  return sample;
+}
+
+double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  const size_t middle = values.size() / 2;
+  return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+}
+
+bool same_contents(const fs::path& a, const fs::path& b) {
+  if (fs::file_size(a) != fs::file_size(b)) return false;
+  std::ifstream file_a(a.string(), std::ios::binary);
+  std::ifstream file_b(b.string(), std::ios::binary);
+  std::vector<char> buffer_a(WRITE_BUFFER_SIZE);
+  std::vector<char> buffer_b(WRITE_BUFFER_SIZE);
+  while (file_a && file_b) {
+    file_a.read(buffer_a.data(), static_cast<std::streamsize>(buffer_a.size()));
+    file_b.read(buffer_b.data(), static_cast<std::streamsize>(buffer_b.size()));
+    if (file_a.gcount() != file_b.gcount() ||
+        !std::equal(buffer_a.data(), buffer_a.data() + file_a.gcount(), buffer_b.data())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string read_log(const fs::path& log) {
+  std::ifstream file(log.string());
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+measurement round_trip(const std::string& huffman, const fs::path& input, const std::string& mode,
+                       const fs::path& work_dir) {
+  const fs::path compressed = work_dir / "compressed.hf";
+  const fs::path decompressed = work_dir / "decompressed";
+  const fs::path log = work_dir / "huffman.log";
+  fs::remove(compressed);
+  fs::remove(decompressed);
+
+  std::vector<std::string> compress_arguments = {huffman, "-c", "-i", input.string(), "-o", compressed.string()};
+  const auto& options = MODE_OPTIONS.at(mode);
+  compress_arguments.insert(compress_arguments.end(), options.begin(), options.end());
+  const run_result compression = run_sample(compress_arguments, compressed, log);
+  if (!fs::exists(compressed)) throw std::runtime_error("Error: compression failed: " + read_log(log));
+  const run_result decompression =
+      run_sample({huffman, "-d", "-i", compressed.string(), "-o", decompressed.string()}, decompressed, log);
+  if (!fs::exists(decompressed)) throw std::runtime_error("Error: decompression failed: " + read_log(log));
+  if (!same_contents(input, decompressed)) throw std::runtime_error("Error: round trip changed the data");
+
+  const double megabytes = static_cast<double>(fs::file_size(input)) / 1e6;
+  fs::remove(compressed);
+  fs::remove(decompressed);
+  return {megabytes / compression.seconds, megabytes / decompression.seconds, compression.peak_rss_mib,
+          decompression.peak_rss_mib};
+}
+
+// Baselines file: a "scale <value>" line, then "<input> <mode> <compress MB/s> <decompress MB/s> <compress peak RSS
+// MiB> <decompress peak RSS MiB>" lines; '#' starts a comment
+std::map<std::string, measurement> read_baselines(const std::string& path, double scale) {
+  std::map<std::string, measurement> baselines;
+  std::ifstream file(path);
+  if (!file) throw std::runtime_error(fmt::format("Error: couldn't read baselines from {}", path));
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line.substr(0, line.find('#')));
+    std::string key;
+    if (!(fields >> key)) continue;
+    if (key == "scale") {
+      double baseline_scale = 0;
+      fields >> baseline_scale;
+      if (baseline_scale != scale) {
+        throw std::runtime_error(
+            fmt::format("Error: baselines were recorded at scale {}, not {} (see --update-baselines)", baseline_scale,
+                        scale));
+      }
+      continue;
+    }
+    std::string mode;
+    measurement m{};
+    if (!(fields >> mode >> m.compress_mb_s >> m.decompress_mb_s >> m.compress_rss_mib >> m.decompress_rss_mib)) {
+      throw std::runtime_error(fmt::format("Error: malformed baseline line: {}", line));
+    }
+    baselines[key + " " + mode] = m;
+  }
+  return baselines;
+}
+
+void write_baselines(const std::string& path, double scale, const std::map<std::string, measurement>& results) {
+  std::ofstream file(path, std::ios::trunc);
+  file << "# Written by huffman_perf_check --update-baselines\n";
+  file << "# <input> <mode> <compress MB/s> <decompress MB/s> <compress peak RSS MiB> <decompress peak RSS MiB>\n";
+  file << fmt::format("scale {}\n", scale);
+  for (const auto& [key, m] : results) {
+    file << fmt::format("{} {:.1f} {:.1f} {:.1f} {:.1f}\n", key, m.compress_mb_s, m.decompress_mb_s,
+                        m.compress_rss_mib, m.decompress_rss_mib);
+  }
+  if (!file) throw std::runtime_error(fmt::format("Error: couldn't write baselines to {}", path));
+}
+
+// Returns the regressions of a result (median throughput, lowest peak RSS) against its baseline, empty if there are
+// none. A slow repetition is more often the machine than the code, so throughput only regresses when every
+// repetition is too slow, i.e. the fastest one; peak RSS barely varies between runs and stays strict.
+std::vector<std::string> compare(const measurement& result, const measurement& fastest, const measurement& baseline,
+                                 bool timed, double tolerance) {
+  std::vector<std::string> regressions;
+  auto check_speed = [&](const char* what, double value, double best, double expected) {
+    if (timed && best < expected * (1.0 - tolerance)) {
+      regressions.push_back(
+          fmt::format("{} {:.1f} MB/s (best {:.1f} MB/s) < baseline {:.1f} MB/s", what, value, best, expected));
+    }
+  };
+  auto check_rss = [&](const char* what, double value, double expected) {
+    if (value > expected * (1.0 + tolerance) + RSS_SLACK_MIB) {
+      regressions.push_back(fmt::format("{} peak RSS {:.1f} MiB > baseline {:.1f} MiB", what, value, expected));
+    }
+  };
+  check_speed("compression", result.compress_mb_s, fastest.compress_mb_s, baseline.compress_mb_s);
+  check_speed("decompression", result.decompress_mb_s, fastest.decompress_mb_s, baseline.decompress_mb_s);
+  check_rss("compression", result.compress_rss_mib, baseline.compress_rss_mib);
+  check_rss("decompression", result.decompress_rss_mib, baseline.decompress_rss_mib);
+  return regressions;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  po::options_description options("huffman_perf_check options", 100);
+  auto o = options.add_options();
+  o("help", "print this help message");
+  o("huffman", po::value<std::string>()->value_name("<path>")->required(), "huffman executable to check");
+  o("corpus", po::value<std::string>()->value_name("<dir>")->default_value("perf_corpus"),
+    "directory for the generated inputs (reused across runs) and the round trip files");
+  o("baselines", po::value<std::string>()->value_name("<file>")->required(), "baselines to compare with");
+  o("scale", po::value<double>()->value_name("<factor>")->default_value(1.0),
+    "multiplies the size of the large inputs (about 3.3 GB in total at 1)");
+  o("tolerance", po::value<double>()->value_name("<percent>")->default_value(10.0),
+    "how much slower or larger than its baseline a run may be");
+  o("repetitions", po::value<unsigned>()->value_name("<count>")->default_value(3),
+    "round trips per input and mode: the median throughput is reported, recorded and compared, but only fails "
+    "if every round trip is too slow; the lowest peak RSS counts");
+  o("filter", po::value<std::string>()->value_name("<text>"), "only check inputs whose name contains the text");
+  o("update-baselines", "record the measurements as the new baselines instead of comparing");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    if (vm.count("help")) {
+      std::cout << options << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (const po::error& e) {
+    std::cout << "Error: " << e.what() << std::endl << options << std::endl;
+    return 2;
+  }
+
+  try {
+    const std::string huffman = fs::absolute(vm["huffman"].as<std::string>()).string();
+    const fs::path corpus_dir = vm["corpus"].as<std::string>();
+    const std::string baselines_path = vm["baselines"].as<std::string>();
+    const double scale = vm["scale"].as<double>();
+    const double tolerance = vm["tolerance"].as<double>() / 100.0;
+    const unsigned repetitions = vm["repetitions"].as<unsigned>();
+    const bool update = vm.count("update-baselines");
+    if (scale <= 0) throw std::runtime_error("Error: scale must be positive");
+    if (repetitions == 0) throw std::runtime_error("Error: number of repetitions must be positive");
+    fs::create_directories(corpus_dir);
+
+    std::map<std::string, measurement> baselines;
+    if (!update) baselines = read_baselines(baselines_path, scale);
+    // Each repetition is a pass over every check, so a slow spell of the machine, which can last minutes, costs a
+    // check at most a repetition or two instead of all of them
+    struct check {
+      std::string key;
+      fs::path input;
+      std::string mode;
+      uint64_t size;
+      std::vector<measurement> samples;
+      std::string error;
+    };
+    std::vector<check> pending;
+    for (const auto& entry : compile_corpus()) {
+      if (vm.count("filter") && entry.name.find(vm["filter"].as<std::string>()) == std::string::npos) continue;
+      const uint64_t size = scaled_size(entry, scale);
+      const fs::path input = corpus_dir / entry.name;
+      prepare_input(entry, size, input);
+      for (const auto& mode : entry.modes) pending.push_back({entry.name + " " + mode, input, mode, size, {}, {}});
+    }
+    for (unsigned repetition = 0; repetition < repetitions; ++repetition) {
+      if (repetitions > 1) std::cout << fmt::format("Repetition {} of {}", repetition + 1, repetitions) << std::endl;
+      for (auto& c : pending) {
+        if (!c.error.empty()) continue;
+        try {
+          c.samples.push_back(round_trip(huffman, c.input, c.mode, corpus_dir));
+        } catch (const std::runtime_error& e) {
+          c.error = e.what();
+        }
+      }
+    }
+
+    std::map<std::string, measurement> results;
+    size_t failures = 0;
+    for (const auto& c : pending) {
+      if (!c.error.empty()) {
+        std::cout << fmt::format("{:<24} FAILED", c.key) << std::endl << "    " << c.error << std::endl;
+        ++failures;
+        continue;
+      }
+      std::vector<double> compress_mb_s;
+      std::vector<double> decompress_mb_s;
+      measurement result = c.samples.front();
+      measurement fastest = result;
+      for (const auto& sample : c.samples) {
+        compress_mb_s.push_back(sample.compress_mb_s);
+        decompress_mb_s.push_back(sample.decompress_mb_s);
+        fastest.compress_mb_s = std::max(fastest.compress_mb_s, sample.compress_mb_s);
+        fastest.decompress_mb_s = std::max(fastest.decompress_mb_s, sample.decompress_mb_s);
+        result.compress_rss_mib = std::min(result.compress_rss_mib, sample.compress_rss_mib);
+        result.decompress_rss_mib = std::min(result.decompress_rss_mib, sample.decompress_rss_mib);
+      }
+      result.compress_mb_s = median(compress_mb_s);
+      result.decompress_mb_s = median(decompress_mb_s);
+      results[c.key] = result;
+      std::vector<std::string> regressions;
+      const auto baseline = baselines.find(c.key);
+      if (!update && baseline == baselines.end()) {
+        regressions.push_back("no baseline");
+      } else if (!update) {
+        regressions = compare(result, fastest, baseline->second, c.size >= MIN_TIMED_SIZE, tolerance);
+      }
+      std::cout << fmt::format("{:<24} {:>9.1f} MB/s {:>9.1f} MB/s {:>8.1f} MiB {:>8.1f} MiB  {}", c.key,
+                               result.compress_mb_s, result.decompress_mb_s, result.compress_rss_mib,
+                               result.decompress_rss_mib, regressions.empty() ? "ok" : "FAILED")
+                << std::endl;
+      for (const auto& regression : regressions) std::cout << "    " << regression << std::endl;
+      if (!regressions.empty()) ++failures;
+    }
+
+    if (update && failures == 0) {
+      write_baselines(baselines_path, scale, results);
+      std::cout << fmt::format("Baselines written to {}", baselines_path) << std::endl;
+    }
+    std::cout << fmt::format("{} checks, {} failed", pending.size(), failures) << std::endl;
+    return failures == 0 ? 0 : 1;
+  } catch (const std::exception& e) {
+    std::cout << e.what() << std::endl;
+    return 2;
+  }
+}
@@ -0,0 +1,28 @@
+#include "adaptive_decoder.hpp"
+
+#include <stdexcept>
+
+#include "adaptive_encoder.hpp"
+#include "table_coder.hpp"
+
+adaptive_decoder::adaptive_decoder() : m_model(true) {}
+
+uint64_t adaptive_decoder::max_encoded_size(uint32_t raw_size) const {
+  return (uint64_t{raw_size} * canonical_code::MAX_CODE_LENGTH + 7u) / 8u;
+}
+
+void adaptive_decoder::decode_chunk(const uint8_t* encoded, size_t encoded_size, size_t raw_size,
+                                    std::vector<uint8_t>& out) {
+  if (raw_size > adaptive_encoder::MAX_CHUNK_SIZE) {
+    throw std::runtime_error("Error: corrupted adaptive chunk (chunk is too large)");
+  }
+  if (raw_size > uint64_t{encoded_size} * 8u) {
+    throw std::runtime_error("Error: corrupted adaptive chunk (encoded data is too short)");
+  }
+  const size_t chunk_start = out.size();
+  out.resize(chunk_start + raw_size);
+  uint8_t* destination = out.data() + chunk_start;
+  table_coder::decode(m_model.get_code(), encoded, encoded_size, destination, raw_size);
+
+  m_model.update(destination, raw_size);
+}
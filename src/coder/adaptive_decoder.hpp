@@ -0,0 +1,25 @@
+#ifndef ADAPTIVE_DECODER_HPP
+#define ADAPTIVE_DECODER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../huffman/adaptive_model.hpp"
+#include "chunk_decoder.hpp"
+
+/// @brief Decoder for the streams produced by adaptive_encoder. The container header is expected to be consumed by
+/// the caller.
+class adaptive_decoder : public chunk_decoder {
+ public:
+  adaptive_decoder();
+
+  uint64_t max_encoded_size(uint32_t raw_size) const override;
+
+  /// @brief Decodes a chunk payload and updates the model with the decoded bytes.
+  void decode_chunk(const uint8_t* encoded, size_t encoded_size, size_t raw_size, std::vector<uint8_t>& out) override;
+
+ private:
+  adaptive_model m_model;
+};
+
+#endif  // ADAPTIVE_DECODER_HPP
@@ -0,0 +1,29 @@
+#include "adaptive_encoder.hpp"
+
+#include <stdexcept>
+
+#include "container.hpp"
+#include "table_coder.hpp"
+
+adaptive_encoder::adaptive_encoder() : m_model(false) {}
+
+void adaptive_encoder::encode_header(std::vector<uint8_t>& out) {
+  container::write_header(out, container::mode::adaptive);
+}
+
+void adaptive_encoder::encode_chunk(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+  if (size == 0 || size > MAX_CHUNK_SIZE) {
+    throw std::logic_error("Error: adaptive chunk size is out of range");
+  }
+  container::write_u32(out, static_cast<uint32_t>(size));
+  const size_t encoded_size_position = out.size();
+  container::write_u32(out, 0);
+
+  const size_t payload_start = out.size();
+  table_coder::encode(m_model.get_code(), data, size, out);
+  container::patch_u32(out, encoded_size_position, static_cast<uint32_t>(out.size() - payload_start));
+
+  m_model.update(data, size);
+}
+
+void adaptive_encoder::encode_end(std::vector<uint8_t>& out) { container::write_u32(out, 0); }
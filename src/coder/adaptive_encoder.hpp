@@ -0,0 +1,35 @@
+#ifndef ADAPTIVE_ENCODER_HPP
+#define ADAPTIVE_ENCODER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../huffman/adaptive_model.hpp"
+#include "chunk_encoder.hpp"
+
+/// @brief Single-pass encoder that doesn't need to see the whole input before emitting data.
+class adaptive_encoder : public chunk_encoder {
+ public:
+  /// @brief Maximum number of bytes in one chunk.
+  static constexpr uint32_t MAX_CHUNK_SIZE = 64u << 20;
+
+  adaptive_encoder();
+
+  /// @brief Appends the container header, has to be called once before the first chunk.
+  void encode_header(std::vector<uint8_t>& out) override;
+
+  /// @brief {raw_size:uint32_t}{encoded_size:uint32_t}[!encoded_data!] - encodes a non-empty chunk of at most
+  /// MAX_CHUNK_SIZE bytes with the current model and then updates the model with the chunk.
+  /// @param data Pointer to the first byte of the chunk.
+  /// @param size Number of bytes in the chunk.
+  /// @param out Vector to append the encoded chunk to.
+  void encode_chunk(const uint8_t* data, size_t size, std::vector<uint8_t>& out) override;
+
+  /// @brief {0:uint32_t} - appends the end-of-stream marker (a chunk with zero bytes).
+  void encode_end(std::vector<uint8_t>& out) override;
+
+ private:
+  adaptive_model m_model;
+};
+
+#endif  // ADAPTIVE_ENCODER_HPP
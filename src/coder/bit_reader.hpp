@@ -0,0 +1,84 @@
+#ifndef BIT_READER_HPP
+#define BIT_READER_HPP
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Reads a least-significant-bit-first stream produced by bit_writer. Reading past the end yields zero bits,
+/// callers check overrun() once they are done. Hot loops use refill_fast() and peek_buffered() while
+/// available_bytes() allows it and switch to the checked peek() for the tail.
+class bit_reader {
+ public:
+  bit_reader(const uint8_t* data, size_t size)
+      : m_begin(data), m_data(data), m_end(data + size), m_buffer(0), m_count(0), m_padding_bytes(0) {}
+
+  /// @brief Returns the number of bits consumed since construction.
+  uint64_t bit_position() const {
+    return (static_cast<uint64_t>(m_data - m_begin) + m_padding_bytes) * 8u - m_count;
+  }
+
+  /// @brief Skips the lowest length bits (at most 7) of the first byte, for streams that start mid-byte. Must be
+  /// called before anything is read, requires at least one byte of data if length is not 0.
+  void skip_first_bits(uint8_t length) {
+    if (length == 0) return;
+    m_buffer = uint64_t{*m_data++} >> length;
+    m_count = 8u - length;
+  }
+
+  /// @brief Returns the next length bits (at most 56) without consuming them.
+  uint32_t peek(uint8_t length) {
+    if (m_count < length) refill();
+    return static_cast<uint32_t>(m_buffer & ((uint64_t{1} << length) - 1u));
+  }
+
+  /// @brief Returns the number of bytes that haven't been loaded into the bit buffer yet.
+  size_t available_bytes() const { return static_cast<size_t>(m_end - m_data); }
+
+  /// @brief Tops the bit buffer up to at least 56 bits with a single 8-byte load. Requires available_bytes() >= 8.
+  void refill_fast() {
+    uint64_t word = 0;
+    for (uint8_t i = 0; i < 8; ++i) {
+      word |= uint64_t{m_data[i]} << (8u * i);
+    }
+    // Bits above m_count may get ORed in twice, but they are the same stream bits both times.
+    m_buffer |= word << m_count;
+    m_data += (63u - m_count) >> 3;
+    m_count |= 56u;
+  }
+
+  /// @brief Returns the next length bits without any refill, they must already be in the buffer.
+  uint32_t peek_buffered(uint8_t length) const {
+    return static_cast<uint32_t>(m_buffer & ((uint64_t{1} << length) - 1u));
+  }
+
+  /// @brief Consumes length bits that were previously peeked.
+  void consume(uint8_t length) {
+    m_buffer >>= length;
+    m_count -= length;
+  }
+
+  /// @brief Tells whether consumed bits went beyond the end of the data.
+  bool overrun() const { return m_padding_bytes * 8u > m_count; }
+
+ private:
+  void refill() {
+    while (m_count <= 56) {
+      uint64_t byte = 0;
+      if (m_data < m_end) {
+        byte = *m_data++;
+      } else {
+        ++m_padding_bytes;
+      }
+      m_buffer |= byte << m_count;
+      m_count += 8;
+    }
+  }
+
+  const uint8_t* m_begin;
+  const uint8_t* m_data;
+  const uint8_t* m_end;
+  uint64_t m_buffer;
+  uint32_t m_count;
+  size_t m_padding_bytes;
+};
+
+#endif  // BIT_READER_HPP
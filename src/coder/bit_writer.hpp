@@ -0,0 +1,48 @@
+#ifndef BIT_WRITER_HPP
+#define BIT_WRITER_HPP
+#include <cstdint>
+#include <vector>
+
+/// @brief Appends variable-length codes to a byte vector, least significant bit first (the same bit order the basic
+/// encoder uses). Codes up to 16 bits long are supported.
+class bit_writer {
+ public:
+  explicit bit_writer(std::vector<uint8_t>& out) : m_out(out), m_start(out.size()), m_buffer(0), m_count(0) {}
+
+  /// @brief Returns the number of bits written since construction.
+  uint64_t bit_count() const { return uint64_t{m_out.size() - m_start} * 8u + m_count; }
+
+  /// @brief Appends the lowest length bits of code.
+  void write(uint32_t code, uint8_t length) {
+    m_buffer |= uint64_t{code} << m_count;
+    m_count += length;
+    if (m_count >= 32) {
+      m_out.push_back(static_cast<uint8_t>(m_buffer));
+      m_out.push_back(static_cast<uint8_t>(m_buffer >> 8));
+      m_out.push_back(static_cast<uint8_t>(m_buffer >> 16));
+      m_out.push_back(static_cast<uint8_t>(m_buffer >> 24));
+      m_buffer >>= 32;
+      m_count -= 32;
+    }
+  }
+
+  /// @brief Flushes pending bits, padding the last byte with zeros.
+  /// @return Number of padding bits in the last byte.
+  uint8_t flush() {
+    const auto padding = static_cast<uint8_t>((8u - m_count % 8u) % 8u);
+    while (m_count > 0) {
+      m_out.push_back(static_cast<uint8_t>(m_buffer));
+      m_buffer >>= 8;
+      m_count = m_count > 8 ? m_count - 8 : 0;
+    }
+    return padding;
+  }
+
+ private:
+  std::vector<uint8_t>& m_out;
+  size_t m_start;
+  uint64_t m_buffer;
+  uint32_t m_count;
+};
+
+#endif  // BIT_WRITER_HPP
@@ -0,0 +1,63 @@
+#include "block_decoder.hpp"
+
+#include <stdexcept>
+
+#include "block_encoder.hpp"
+#include "container.hpp"
+#include "crc32.hpp"
+#include "table_coder.hpp"
+
+block_decoder::block_decoder() : m_cache(code_cache::DEFAULT_CAPACITY, true), m_previous_code(nullptr) {}
+
+uint64_t block_decoder::max_encoded_size(uint32_t raw_size) const {
+  // Flags, checksum, lengths and the payload
+  return 1u + sizeof(uint32_t) + canonical_code::PACKED_LENGTHS_SIZE +
+         (uint64_t{raw_size} * canonical_code::MAX_CODE_LENGTH + 7u) / 8u;
+}
+
+void block_decoder::decode_chunk(const uint8_t* encoded, size_t encoded_size, size_t raw_size,
+                                 std::vector<uint8_t>& out) {
+  if (raw_size > block_encoder::MAX_BLOCK_SIZE) {
+    throw std::runtime_error("Error: corrupted block (block is too large)");
+  }
+  if (encoded_size < 1) {
+    throw std::runtime_error("Error: corrupted block (missing flags)");
+  }
+  const uint8_t flags = *encoded;
+  ++encoded;
+  --encoded_size;
+  if (flags & ~(block_encoder::REPEAT_PREVIOUS_CODE | block_encoder::HAS_CHECKSUM)) {
+    throw std::runtime_error("Error: corrupted block (unknown flags)");
+  }
+  uint32_t checksum = 0;
+  if (flags & block_encoder::HAS_CHECKSUM) {
+    if (encoded_size < sizeof(uint32_t)) {
+      throw std::runtime_error("Error: corrupted block (truncated checksum)");
+    }
+    checksum = container::read_u32(encoded);
+    encoded += sizeof(uint32_t);
+    encoded_size -= sizeof(uint32_t);
+  }
+  if (flags & block_encoder::REPEAT_PREVIOUS_CODE) {
+    if (!m_previous_code) {
+      throw std::runtime_error("Error: corrupted block (no code to repeat)");
+    }
+  } else {
+    if (encoded_size < canonical_code::PACKED_LENGTHS_SIZE) {
+      throw std::runtime_error("Error: corrupted block (truncated code lengths)");
+    }
+    m_previous_code = m_cache.get(canonical_code::read_lengths(encoded));
+    encoded += canonical_code::PACKED_LENGTHS_SIZE;
+    encoded_size -= canonical_code::PACKED_LENGTHS_SIZE;
+  }
+  if (raw_size > uint64_t{encoded_size} * 8u) {
+    throw std::runtime_error("Error: corrupted block (encoded data is too short)");
+  }
+
+  const size_t block_start = out.size();
+  out.resize(block_start + raw_size);
+  table_coder::decode(*m_previous_code, encoded, encoded_size, out.data() + block_start, raw_size);
+  if ((flags & block_encoder::HAS_CHECKSUM) && crc32::compute(out.data() + block_start, raw_size) != checksum) {
+    throw std::runtime_error("Error: corrupted block (checksum mismatch)");
+  }
+}
@@ -0,0 +1,31 @@
+#ifndef BLOCK_DECODER_HPP
+#define BLOCK_DECODER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../huffman/canonical_code.hpp"
+#include "../huffman/code_cache.hpp"
+#include "chunk_decoder.hpp"
+
+/// @brief Decoder for the streams produced by block_encoder. The container header is expected to be consumed by the
+/// caller.
+class block_decoder : public chunk_decoder {
+ public:
+  block_decoder();
+
+  uint64_t max_encoded_size(uint32_t raw_size) const override;
+
+  /// @brief Decodes a block, resolving its code through the cache.
+  void decode_chunk(const uint8_t* encoded, size_t encoded_size, size_t raw_size, std::vector<uint8_t>& out) override;
+
+  /// @brief Returns the cache of built codes.
+  const code_cache& get_cache() const { return m_cache; }
+
+ private:
+  code_cache m_cache;
+  std::shared_ptr<const canonical_code> m_previous_code;
+};
+
+#endif  // BLOCK_DECODER_HPP
@@ -0,0 +1,121 @@
+#include "block_encoder.hpp"
+
+#include <stdexcept>
+
+#include "../huffman/huffman.hpp"
+#include "container.hpp"
+#include "crc32.hpp"
+#include "parallel.hpp"
+#include "table_coder.hpp"
+
+block_encoder::block_encoder(uint32_t reuse_tolerance_percent)
+    : block_encoder(reuse_tolerance_percent, canonical_code::MAX_CODE_LENGTH, 0, false) {}
+
+block_encoder::block_encoder(uint32_t reuse_tolerance_percent, uint8_t max_code_length, uint32_t sampling_interval,
+                             bool checksum)
+    : m_reuse_tolerance_percent(reuse_tolerance_percent),
+      m_max_code_length(max_code_length),
+      m_sampling_interval(sampling_interval),
+      m_checksum(checksum),
+      m_cache(code_cache::DEFAULT_CAPACITY, false),
+      m_previous_code(nullptr),
+      m_repeated_blocks(0) {}
+
+void block_encoder::encode_header(std::vector<uint8_t>& out) { container::write_header(out, container::mode::block); }
+
+void block_encoder::encode_chunk(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+  if (size == 0 || size > MAX_BLOCK_SIZE) {
+    throw std::logic_error("Error: block size is out of range");
+  }
+  std::array<uint64_t, 256> frequencies{};
+  count_block_frequencies(data, size, frequencies);
+  const bool repeat_previous =
+      select_code(frequencies, huffman::calculate_code_lengths(frequencies, m_max_code_length));
+  write_block(*m_previous_code, repeat_previous, data, size, out);
+}
+
+void block_encoder::encode_blocks(const uint8_t* data, const std::vector<size_t>& block_sizes, unsigned threads,
+                                  std::vector<uint8_t>& out) {
+  const size_t count = block_sizes.size();
+  std::vector<size_t> offsets(count);
+  for (size_t i = 0, offset = 0; i < count; offset += block_sizes[i++]) {
+    if (block_sizes[i] == 0 || block_sizes[i] > MAX_BLOCK_SIZE) {
+      throw std::logic_error("Error: block size is out of range");
+    }
+    offsets[i] = offset;
+  }
+
+  // Histograms and code lengths don't depend on other blocks
+  std::vector<std::array<uint64_t, 256>> frequencies(count);
+  std::vector<std::array<uint8_t, 256>> lengths(count);
+  parallel::for_each(threads, count, [&](size_t i) {
+    frequencies[i].fill(0);
+    count_block_frequencies(data + offsets[i], block_sizes[i], frequencies[i]);
+    lengths[i] = huffman::calculate_code_lengths(frequencies[i], m_max_code_length);
+  });
+
+  // Reusing the previous code chains blocks together, but the decision only needs the lengths
+  std::vector<std::shared_ptr<const canonical_code>> codes(count);
+  std::vector<uint8_t> repeat_previous(count);
+  for (size_t i = 0; i < count; ++i) {
+    repeat_previous[i] = select_code(frequencies[i], lengths[i]);
+    codes[i] = m_previous_code;
+  }
+
+  std::vector<std::vector<uint8_t>> encoded_blocks(count);
+  parallel::for_each(threads, count, [&](size_t i) {
+    encoded_blocks[i].reserve(block_sizes[i] + canonical_code::PACKED_LENGTHS_SIZE + 16u);
+    write_block(*codes[i], repeat_previous[i], data + offsets[i], block_sizes[i], encoded_blocks[i]);
+  });
+  size_t total_size = out.size();
+  for (const auto& encoded_block : encoded_blocks) {
+    total_size += encoded_block.size();
+  }
+  out.reserve(total_size);
+  for (auto& encoded_block : encoded_blocks) {
+    out.insert(out.end(), encoded_block.begin(), encoded_block.end());
+    std::vector<uint8_t>().swap(encoded_block);
+  }
+}
+
+void block_encoder::encode_end(std::vector<uint8_t>& out) { container::write_u32(out, 0); }
+
+void block_encoder::count_block_frequencies(const uint8_t* data, size_t size,
+                                            std::array<uint64_t, 256>& frequencies) const {
+  // A sampled histogram gives every byte a code, so codes built from it fit any block
+  if (m_sampling_interval > 0) {
+    huffman::sample_frequencies(data, size, m_sampling_interval, frequencies);
+  } else {
+    huffman::count_frequencies(data, size, frequencies);
+  }
+}
+
+bool block_encoder::select_code(const std::array<uint64_t, 256>& frequencies, const std::array<uint8_t, 256>& lengths) {
+  // Own code: payload plus the stored lengths. Previous code: payload only, if it covers every byte of the block.
+  uint64_t own_bits = canonical_code::PACKED_LENGTHS_SIZE * 8u;
+  for (size_t byte = 0; byte < 256; ++byte) {
+    own_bits += frequencies[byte] * lengths[byte];
+  }
+  const uint64_t previous_bits = m_previous_code ? m_previous_code->calculate_encoded_bits(frequencies) : UINT64_MAX;
+  const bool repeat_previous =
+      previous_bits != UINT64_MAX && previous_bits * 100u <= own_bits * (100u + m_reuse_tolerance_percent);
+  if (repeat_previous) {
+    ++m_repeated_blocks;
+  } else {
+    m_previous_code = m_cache.get(lengths);
+  }
+  return repeat_previous;
+}
+
+void block_encoder::write_block(const canonical_code& code, bool repeat_previous, const uint8_t* data, size_t size,
+                                std::vector<uint8_t>& out) const {
+  container::write_u32(out, static_cast<uint32_t>(size));
+  const size_t encoded_size_position = out.size();
+  container::write_u32(out, 0);
+  const size_t block_start = out.size();
+  out.push_back(static_cast<uint8_t>((repeat_previous ? REPEAT_PREVIOUS_CODE : 0) | (m_checksum ? HAS_CHECKSUM : 0)));
+  if (m_checksum) container::write_u32(out, crc32::compute(data, size));
+  if (!repeat_previous) code.write_lengths(out);
+  table_coder::encode(code, data, size, out);
+  container::patch_u32(out, encoded_size_position, static_cast<uint32_t>(out.size() - block_start));
+}
@@ -0,0 +1,88 @@
+#ifndef BLOCK_ENCODER_HPP
+#define BLOCK_ENCODER_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../huffman/canonical_code.hpp"
+#include "../huffman/code_cache.hpp"
+#include "chunk_encoder.hpp"
+
+/// @brief Encoder that splits the input into independently sized blocks, each with its own canonical code.
+class block_encoder : public chunk_encoder {
+ public:
+  /// @brief Maximum number of bytes in one block.
+  static constexpr uint32_t MAX_BLOCK_SIZE = 64u << 20;
+
+  /// @brief Code reuse tolerance of block mode without --level, in percent.
+  static constexpr uint32_t DEFAULT_REUSE_TOLERANCE_PERCENT = 1;
+
+  /// @brief Block flag: the block is coded with the code of the previous block, no lengths are stored.
+  static constexpr uint8_t REPEAT_PREVIOUS_CODE = 0x01;
+
+  /// @brief Block flag: a CRC-32 of the raw block follows the flags.
+  static constexpr uint8_t HAS_CHECKSUM = 0x02;
+
+  /// @brief Constructs an encoder that counts every byte, builds codes of up to canonical_code::MAX_CODE_LENGTH bits
+  /// and stores no checksums.
+  /// @param reuse_tolerance_percent How much larger (in percent) the block may get when coded with the previous
+  /// block's code instead of its own code (including the cost of storing the lengths).
+  explicit block_encoder(uint32_t reuse_tolerance_percent);
+
+  /// @brief Constructs an encoder.
+  /// @param reuse_tolerance_percent See above.
+  /// @param max_code_length Maximum code length, from 8 to canonical_code::MAX_CODE_LENGTH.
+  /// @param sampling_interval Estimate each block's histogram from a sample, see huffman::sample_frequencies(); 0 to
+  /// count every byte.
+  /// @param checksum Whether to store a CRC-32 of every block, which the decoder verifies.
+  block_encoder(uint32_t reuse_tolerance_percent, uint8_t max_code_length, uint32_t sampling_interval, bool checksum);
+
+  /// @brief Appends the container header, has to be called once before the first block.
+  void encode_header(std::vector<uint8_t>& out) override;
+
+  /// @brief {raw_size:uint32_t}{encoded_size:uint32_t}{flags:uint8_t}[crc32:uint32_t][lengths:128 x uint8_t]
+  /// [!encoded_data!] - encodes a non-empty block of at most MAX_BLOCK_SIZE bytes. encoded_size counts everything
+  /// after itself, the checksum is present if flags has HAS_CHECKSUM set, the lengths are omitted if flags has
+  /// REPEAT_PREVIOUS_CODE set.
+  /// @param data Pointer to the first byte of the block.
+  /// @param size Number of bytes in the block.
+  /// @param out Vector to append the encoded block to.
+  void encode_chunk(const uint8_t* data, size_t size, std::vector<uint8_t>& out) override;
+
+  /// @brief Encodes consecutive blocks like encode_chunk() does one after another, producing the same output, but
+  /// on several threads: histograms and payloads are coded in parallel, only the cheap choice between a block's own
+  /// code and the previous one runs sequentially.
+  /// @param data Pointer to the first byte of the first block.
+  /// @param block_sizes Size of each block, see encode_chunk() for the limits.
+  /// @param threads Maximum number of threads.
+  /// @param out Vector to append the encoded blocks to.
+  void encode_blocks(const uint8_t* data, const std::vector<size_t>& block_sizes, unsigned threads,
+                     std::vector<uint8_t>& out);
+
+  /// @brief {0:uint32_t} - appends the end-of-stream marker (a block with zero bytes).
+  void encode_end(std::vector<uint8_t>& out) override;
+
+  /// @brief Returns the number of blocks that reused the previous block's code.
+  uint64_t get_repeated_blocks() const { return m_repeated_blocks; }
+
+  /// @brief Returns the cache of built codes.
+  const code_cache& get_cache() const { return m_cache; }
+
+ private:
+  uint32_t m_reuse_tolerance_percent;
+  uint8_t m_max_code_length;
+  uint32_t m_sampling_interval;
+  bool m_checksum;
+  code_cache m_cache;
+  std::shared_ptr<const canonical_code> m_previous_code;
+  uint64_t m_repeated_blocks;
+
+  void count_block_frequencies(const uint8_t* data, size_t size, std::array<uint64_t, 256>& frequencies) const;
+  bool select_code(const std::array<uint64_t, 256>& frequencies, const std::array<uint8_t, 256>& lengths);
+  void write_block(const canonical_code& code, bool repeat_previous, const uint8_t* data, size_t size,
+                   std::vector<uint8_t>& out) const;
+};
+
+#endif  // BLOCK_ENCODER_HPP
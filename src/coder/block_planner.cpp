@@ -0,0 +1,154 @@
+#include "block_planner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include "parallel.hpp"
+
+namespace {
+
+using histogram = std::array<uint32_t, 256>;
+
+// log2 with an error below 0.01, about ten times faster than std::log2. The exponent comes from the float
+// representation, a quadratic fits log2 of the mantissa on [1, 2).
+inline float fast_log2(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const auto exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+  bits = (bits & 0x7FFFFFu) | 0x3F800000u;
+  float mantissa;
+  std::memcpy(&mantissa, &bits, sizeof(mantissa));
+  return exponent + (-0.34484843f * mantissa + 2.02466578f) * mantissa - 0.67487759f;
+}
+
+// x * log2(x) with 0 * log2(0) = 0.
+inline float entropy_term(uint32_t count) {
+  const auto value = static_cast<float>(count);
+  return count == 0 ? 0.0f : value * fast_log2(value);
+}
+
+// Extra bits needed to code a and b with one shared code rather than a code each, estimated with Shannon code
+// lengths (a Huffman code of a histogram h costs about sum(h[i] * log2(total / h[i])) bits). It's the
+// Jensen-Shannon divergence of the two histograms scaled by their total count, so it grows with how different they
+// are and with how much data there is.
+float merge_cost(const histogram& a, uint32_t a_total, const histogram& b, uint32_t b_total) {
+  float sum = 0.0f;
+  for (size_t byte = 0; byte < 256; ++byte) {
+    sum += entropy_term(a[byte] + b[byte]) - entropy_term(a[byte]) - entropy_term(b[byte]);
+  }
+  return entropy_term(a_total + b_total) - entropy_term(a_total) - entropy_term(b_total) - sum;
+}
+
+void add(histogram& target, const histogram& source) {
+  for (size_t byte = 0; byte < 256; ++byte) {
+    target[byte] += source[byte];
+  }
+}
+
+void subtract(histogram& target, const histogram& source) {
+  for (size_t byte = 0; byte < 256; ++byte) {
+    target[byte] -= source[byte];
+  }
+}
+
+}  // namespace
+
+block_planner::block_planner(size_t max_block_size) : m_max_block_size(max_block_size) {
+  if (max_block_size < SEGMENT_SIZE) {
+    throw std::logic_error("Error: maximum block size is smaller than a planning segment");
+  }
+}
+
+std::vector<size_t> block_planner::plan(const uint8_t* data, size_t size, unsigned threads) const {
+  const size_t segments = (size + SEGMENT_SIZE - 1u) / SEGMENT_SIZE;
+  std::vector<histogram> histograms(segments);
+  std::vector<uint32_t> totals(segments);
+  parallel::for_each(threads, segments, [&](size_t i) {
+    // Counts are summed into 32 bits, which is plenty for blocks of at most 64 MiB
+    std::array<histogram, 4> partial{};
+    const uint8_t* segment = data + i * SEGMENT_SIZE;
+    const size_t segment_size = std::min(SEGMENT_SIZE, size - i * SEGMENT_SIZE);
+    size_t j = 0;
+    for (; j + 4 <= segment_size; j += 4) {
+      ++partial[0][segment[j]];
+      ++partial[1][segment[j + 1]];
+      ++partial[2][segment[j + 2]];
+      ++partial[3][segment[j + 3]];
+    }
+    for (; j < segment_size; ++j) {
+      ++partial[0][segment[j]];
+    }
+    for (size_t byte = 0; byte < 256; ++byte) {
+      histograms[i][byte] = partial[0][byte] + partial[1][byte] + partial[2][byte] + partial[3][byte];
+    }
+    totals[i] = static_cast<uint32_t>(segment_size);
+  });
+
+  std::vector<size_t> block_sizes;
+  if (segments == 0) return block_sizes;
+  const size_t max_block_segments = m_max_block_size / SEGMENT_SIZE;
+
+  // The current block covers segments [block_start, next). It is compared with the window that follows it,
+  // [next, window_end), through its own last WINDOW_SEGMENTS segments: a change in the data shows up as divergence
+  // between the two, and the counts stay small enough for single precision.
+  histogram tail{};
+  uint32_t tail_total = 0;
+  histogram window{};
+  uint32_t window_total = 0;
+  size_t block_start = 0;
+  size_t window_end = 0;
+  auto move_to_tail = [&](size_t segment) {
+    add(tail, histograms[segment]);
+    tail_total += totals[segment];
+    subtract(window, histograms[segment]);
+    window_total -= totals[segment];
+  };
+  auto end_block = [&](size_t end) {
+    block_sizes.push_back(std::min(end * SEGMENT_SIZE, size) - block_start * SEGMENT_SIZE);
+    block_start = end;
+    tail = histogram{};
+    tail_total = 0;
+  };
+
+  for (size_t next = 0; next < segments; ++next) {
+    for (; window_end < std::min(next + WINDOW_SEGMENTS, segments); ++window_end) {
+      add(window, histograms[window_end]);
+      window_total += totals[window_end];
+    }
+    if (next - block_start >= max_block_segments) {
+      end_block(next);
+    } else if (next > block_start && merge_cost(tail, tail_total, window, window_total) > NEW_CODE_BITS) {
+      // The data changes somewhere in the window: split where the two sides differ the most
+      size_t best_split = next;
+      float best_cost = merge_cost(tail, tail_total, window, window_total);
+      histogram left = tail;
+      uint32_t left_total = tail_total;
+      histogram right = window;
+      uint32_t right_total = window_total;
+      for (size_t split = next + 1; split < window_end && split - block_start < max_block_segments; ++split) {
+        add(left, histograms[split - 1]);
+        left_total += totals[split - 1];
+        subtract(right, histograms[split - 1]);
+        right_total -= totals[split - 1];
+        const float cost = merge_cost(left, left_total, right, right_total);
+        if (cost > best_cost) {
+          best_cost = cost;
+          best_split = split;
+        }
+      }
+      for (; next < best_split; ++next) {
+        move_to_tail(next);
+      }
+      end_block(best_split);
+    }
+    move_to_tail(next);
+    if (next - block_start >= WINDOW_SEGMENTS) {
+      subtract(tail, histograms[next - WINDOW_SEGMENTS]);
+      tail_total -= totals[next - WINDOW_SEGMENTS];
+    }
+  }
+  end_block(segments);
+  return block_sizes;
+}
@@ -0,0 +1,37 @@
+#ifndef BLOCK_PLANNER_HPP
+#define BLOCK_PLANNER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Chooses block boundaries for block_encoder from the data instead of cutting it every N bytes. The input is
+/// split into segments whose histograms are counted in parallel; a single pass then grows the current block segment
+/// by segment and ends it where the data that follows would be cheaper to code with a code of its own, including
+/// the cost of storing that code.
+class block_planner {
+ public:
+  /// @brief Granularity of the plan: blocks start and end at multiples of this size (except the last one).
+  static constexpr size_t SEGMENT_SIZE = 16u << 10;
+
+  /// @brief Number of segments after the current block that are compared with it.
+  static constexpr size_t WINDOW_SEGMENTS = 4;
+
+  /// @brief Estimated cost of starting a block with its own code, in bits: block header, flags and code lengths.
+  static constexpr double NEW_CODE_BITS = (8u + 1u + 128u) * 8.0;
+
+  /// @brief Constructs a planner.
+  /// @param max_block_size Upper bound of a block size, at least SEGMENT_SIZE.
+  explicit block_planner(size_t max_block_size);
+
+  /// @brief Plans blocks over the given data.
+  /// @param data Pointer to the first byte.
+  /// @param size Number of bytes.
+  /// @param threads Maximum number of threads used to count histograms.
+  /// @return Block sizes that add up to size, each at most the maximum block size.
+  std::vector<size_t> plan(const uint8_t* data, size_t size, unsigned threads) const;
+
+ private:
+  size_t m_max_block_size;
+};
+
+#endif  // BLOCK_PLANNER_HPP
@@ -0,0 +1,29 @@
+#ifndef CHUNK_DECODER_HPP
+#define CHUNK_DECODER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Interface of the decoders for the streams produced by chunk_encoder implementations. The container header
+/// and the size fields of each chunk are consumed by the caller.
+class chunk_decoder {
+ public:
+  /// @brief Size of the {raw_size:uint32_t}{encoded_size:uint32_t} prefix of each chunk.
+  static constexpr size_t CHUNK_HEADER_SIZE = 8;
+
+  virtual ~chunk_decoder() = default;
+
+  /// @brief Returns an upper bound of encoded_size for a valid chunk, larger values mean the stream is corrupted.
+  /// @param raw_size Value of the raw_size field.
+  virtual uint64_t max_encoded_size(uint32_t raw_size) const = 0;
+
+  /// @brief Decodes a chunk and appends its bytes to out. Throws std::runtime_error if the chunk is malformed.
+  /// @param encoded Pointer to the chunk data right after its encoded_size field.
+  /// @param encoded_size Value of the encoded_size field.
+  /// @param raw_size Value of the raw_size field.
+  /// @param out Vector to append the decoded bytes to.
+  virtual void decode_chunk(const uint8_t* encoded, size_t encoded_size, size_t raw_size,
+                            std::vector<uint8_t>& out) = 0;
+};
+
+#endif  // CHUNK_DECODER_HPP
@@ -0,0 +1,26 @@
+#ifndef CHUNK_ENCODER_HPP
+#define CHUNK_ENCODER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Interface of the encoders that code the input as a sequence of self-delimiting chunks:
+/// [header]({raw_size:uint32_t}{encoded_size:uint32_t}[...encoded_size bytes...])*{0:uint32_t}
+class chunk_encoder {
+ public:
+  virtual ~chunk_encoder() = default;
+
+  /// @brief Appends the container header, has to be called once before the first chunk.
+  virtual void encode_header(std::vector<uint8_t>& out) = 0;
+
+  /// @brief Encodes a non-empty chunk.
+  /// @param data Pointer to the first byte of the chunk.
+  /// @param size Number of bytes in the chunk.
+  /// @param out Vector to append the encoded chunk to.
+  virtual void encode_chunk(const uint8_t* data, size_t size, std::vector<uint8_t>& out) = 0;
+
+  /// @brief {0:uint32_t} - appends the end-of-stream marker (a chunk with zero bytes).
+  virtual void encode_end(std::vector<uint8_t>& out) = 0;
+};
+
+#endif  // CHUNK_ENCODER_HPP
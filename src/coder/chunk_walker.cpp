@@ -0,0 +1,103 @@
+#include "chunk_walker.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+chunk_walker::chunk_walker(read_function read)
+    : m_read(std::move(read)),
+      m_decoder(nullptr),
+      m_encoded_bytes(0),
+      m_streams(0),
+      m_cache_hits(0),
+      m_cache_misses(0) {}
+
+void chunk_walker::begin(container::mode coding_mode) {
+  m_encoded_bytes += container::HEADER_SIZE;
+  start_stream(coding_mode);
+}
+
+void chunk_walker::start_stream(container::mode coding_mode) {
+  if (coding_mode == container::mode::adaptive) {
+    m_adaptive_decoder = std::make_unique<adaptive_decoder>();
+    m_decoder = m_adaptive_decoder.get();
+  } else if (coding_mode == container::mode::block) {
+    m_block_decoder = std::make_unique<block_decoder>();
+    m_decoder = m_block_decoder.get();
+  } else {
+    throw std::runtime_error("Error: corrupted data (expected an adaptive or block stream)");
+  }
+  ++m_streams;
+}
+
+bool chunk_walker::next_chunk(std::vector<uint8_t>& out) {
+  while (true) {
+    if (m_decoder == nullptr) {
+      const uint8_t* header = nullptr;
+      const size_t available = m_read(container::HEADER_SIZE, header);
+      m_encoded_bytes += available;
+      if (available == 0 && m_streams > 0) return false;
+      if (!container::has_header(header, available)) {
+        throw std::runtime_error(m_streams > 0 ? "Error: corrupted data (trailing bytes after the end marker)"
+                                               : "Error: corrupted data (unexpected end of data)");
+      }
+      const container::mode coding_mode = container::read_mode(header);
+      if (m_streams > 0 && coding_mode != container::mode::adaptive && coding_mode != container::mode::block) {
+        throw std::runtime_error("Error: corrupted data (trailing bytes after the end marker)");
+      }
+      start_stream(coding_mode);
+    }
+
+    const uint32_t raw_size = container::read_u32(read_exactly(sizeof(uint32_t)));
+    if (raw_size == 0) {
+      end_stream();
+      continue;
+    }
+    const uint32_t encoded_size = container::read_u32(read_exactly(sizeof(uint32_t)));
+    if (encoded_size > m_decoder->max_encoded_size(raw_size)) {
+      throw std::runtime_error("Error: corrupted data (chunk is larger than possible)");
+    }
+    m_decoder->decode_chunk(read_exactly(encoded_size), encoded_size, raw_size, out);
+    return true;
+  }
+}
+
+void chunk_walker::decode(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+  size_t position = 0;
+  chunk_walker walker([data, size, &position](size_t wanted, const uint8_t*& chunk) {
+    const size_t available = std::min(wanted, size - position);
+    chunk = data + position;
+    position += available;
+    return available;
+  });
+  while (walker.next_chunk(out)) {
+  }
+}
+
+uint64_t chunk_walker::get_cache_hits() const {
+  return m_cache_hits + (m_block_decoder ? m_block_decoder->get_cache().get_hits() : 0);
+}
+
+uint64_t chunk_walker::get_cache_misses() const {
+  return m_cache_misses + (m_block_decoder ? m_block_decoder->get_cache().get_misses() : 0);
+}
+
+const uint8_t* chunk_walker::read_exactly(size_t size) {
+  const uint8_t* data = nullptr;
+  const size_t available = m_read(size, data);
+  m_encoded_bytes += available;
+  if (available != size) {
+    throw std::runtime_error("Error: corrupted data (unexpected end of data)");
+  }
+  return data;
+}
+
+void chunk_walker::end_stream() {
+  if (m_block_decoder) {
+    m_cache_hits += m_block_decoder->get_cache().get_hits();
+    m_cache_misses += m_block_decoder->get_cache().get_misses();
+    m_block_decoder.reset();
+  }
+  m_adaptive_decoder.reset();
+  m_decoder = nullptr;
+}
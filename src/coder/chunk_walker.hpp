@@ -0,0 +1,70 @@
+#ifndef CHUNK_WALKER_HPP
+#define CHUNK_WALKER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "adaptive_decoder.hpp"
+#include "block_decoder.hpp"
+#include "chunk_decoder.hpp"
+#include "container.hpp"
+
+/// @brief Walks the streams of the adaptive and block modes, {header}{raw_size}{encoded_size}[chunk]... {0}, and
+/// decodes them chunk by chunk. Both formats end with a marker, so streams appended to one another are walked one
+/// after the other, each with a fresh decoder; anything else after an end marker is rejected as corrupted. This is
+/// the only chunk walk, used by decompression_coordinator to stream files and by member_decoder on memory.
+class chunk_walker {
+ public:
+  /// @brief Supplies the input: points data at the next size bytes, valid until the next call, and returns how many
+  /// are available, fewer than size only at the end of the input.
+  using read_function = std::function<size_t(size_t size, const uint8_t*& data)>;
+
+  /// @brief Constructs a walker that reads the first stream's header itself.
+  /// @param read Input of the walk.
+  explicit chunk_walker(read_function read);
+
+  /// @brief Starts the first stream when the caller has already consumed its header.
+  /// @param coding_mode Mode from that header, adaptive or block.
+  void begin(container::mode coding_mode);
+
+  /// @brief Decodes the next chunk and appends its bytes to out. Throws std::runtime_error on malformed data.
+  /// @param out Vector to append the decoded bytes to.
+  /// @return False once the input ends right after an end marker.
+  bool next_chunk(std::vector<uint8_t>& out);
+
+  /// @brief Decodes every stream of a buffer holding adaptive or block streams (with their headers).
+  /// @param data Pointer to the first byte.
+  /// @param size Number of bytes.
+  /// @param out Vector to append the decoded data to.
+  static void decode(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+  /// @brief Returns the number of input bytes read so far, including a header consumed by the caller.
+  uint64_t get_encoded_bytes() const { return m_encoded_bytes; }
+
+  /// @brief Returns the number of streams started so far.
+  uint64_t get_streams() const { return m_streams; }
+
+  /// @brief Returns the code cache hits of all block streams so far.
+  uint64_t get_cache_hits() const;
+
+  /// @brief Returns the code cache misses of all block streams so far.
+  uint64_t get_cache_misses() const;
+
+ private:
+  read_function m_read;
+  std::unique_ptr<adaptive_decoder> m_adaptive_decoder;
+  std::unique_ptr<block_decoder> m_block_decoder;
+  chunk_decoder* m_decoder;  // Decoder of the current stream, null between streams
+  uint64_t m_encoded_bytes;
+  uint64_t m_streams;
+  uint64_t m_cache_hits;  // Of the finished block streams
+  uint64_t m_cache_misses;
+
+  void start_stream(container::mode coding_mode);
+  const uint8_t* read_exactly(size_t size);
+  void end_stream();
+};
+
+#endif  // CHUNK_WALKER_HPP
@@ -0,0 +1,60 @@
+#include "container.hpp"
+
+#include <fmt/core.h>
+
+#include <stdexcept>
+
+namespace {
+
+const uint8_t MAGIC[] = {'H', 'F', 0x00};
+
+}  // namespace
+
+void container::write_header(std::vector<uint8_t>& out, mode coding_mode) {
+  out.insert(out.end(), std::begin(MAGIC), std::end(MAGIC));
+  out.push_back(static_cast<uint8_t>(coding_mode));
+}
+
+bool container::has_header(const uint8_t* data, size_t size) {
+  return size >= HEADER_SIZE && data[0] == MAGIC[0] && data[1] == MAGIC[1] && data[2] == MAGIC[2];
+}
+
+container::mode container::read_mode(const uint8_t* data) {
+  const uint8_t value = data[3];
+  if (value < static_cast<uint8_t>(mode::adaptive) || value > static_cast<uint8_t>(mode::member)) {
+    throw std::runtime_error(fmt::format("Error: unknown coding mode {}", value));
+  }
+  return static_cast<mode>(value);
+}
+
+void container::write_u32(std::vector<uint8_t>& out, uint32_t value) {
+  for (uint8_t shift = 0; shift < 32; shift += 8) {
+    out.push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+void container::patch_u32(std::vector<uint8_t>& out, size_t position, uint32_t value) {
+  for (uint8_t shift = 0; shift < 32; shift += 8) {
+    out[position++] = static_cast<uint8_t>(value >> shift);
+  }
+}
+
+uint32_t container::read_u32(const uint8_t* data) {
+  return uint32_t{data[0]} | uint32_t{data[1]} << 8 | uint32_t{data[2]} << 16 | uint32_t{data[3]} << 24;
+}
+
+void container::write_u64(std::vector<uint8_t>& out, uint64_t value) {
+  for (uint8_t shift = 0; shift < 64; shift += 8) {
+    out.push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+void container::patch_u64(std::vector<uint8_t>& out, size_t position, uint64_t value) {
+  for (uint8_t shift = 0; shift < 64; shift += 8) {
+    out[position++] = static_cast<uint8_t>(value >> shift);
+  }
+}
+
+uint64_t container::read_u64(const uint8_t* data) {
+  return uint64_t{read_u32(data)} | uint64_t{read_u32(data + 4)} << 32;
+}
@@ -0,0 +1,56 @@
+#ifndef CONTAINER_HPP
+#define CONTAINER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Header shared by the coding modes introduced after the basic format: {'H'}{'F'}{0x00}{mode:uint8_t}.
+/// A basic-format file can't start with it: there the third byte is the length of the first code, which is never 0.
+class container {
+ public:
+  /// @brief Coding mode stored in the header.
+  enum class mode : uint8_t {
+    /// @brief Chunks coded with a model rebuilt from running byte counts, see adaptive_encoder.
+    adaptive = 1,
+    /// @brief Blocks coded with their own (or the previous block's) canonical code, see block_encoder.
+    block = 2,
+    /// @brief The whole input coded as one stream with optional sync points for parallel decoding, see stream_encoder.
+    stream = 3,
+    /// @brief Length-prefixed frame around the complete output of another mode, see member_frame.
+    member = 4
+  };
+
+  static constexpr size_t HEADER_SIZE = 4;
+
+  /// @brief Appends the header for the given mode.
+  static void write_header(std::vector<uint8_t>& out, mode coding_mode);
+
+  /// @brief Tells whether the data starts with a container header (of any mode).
+  /// @param data Pointer to the first byte.
+  /// @param size Number of available bytes, at least HEADER_SIZE are needed for a positive answer.
+  static bool has_header(const uint8_t* data, size_t size);
+
+  /// @brief Reads the mode from a header. Throws std::runtime_error for modes this version doesn't know.
+  /// @param data Pointer to the header, has_header() must hold.
+  static mode read_mode(const uint8_t* data);
+
+  /// @brief Appends a 32-bit little-endian integer.
+  static void write_u32(std::vector<uint8_t>& out, uint32_t value);
+
+  /// @brief Overwrites 4 bytes at the given position with a 32-bit little-endian integer.
+  static void patch_u32(std::vector<uint8_t>& out, size_t position, uint32_t value);
+
+  /// @brief Reads a 32-bit little-endian integer.
+  static uint32_t read_u32(const uint8_t* data);
+
+  /// @brief Appends a 64-bit little-endian integer.
+  static void write_u64(std::vector<uint8_t>& out, uint64_t value);
+
+  /// @brief Overwrites 8 bytes at the given position with a 64-bit little-endian integer.
+  static void patch_u64(std::vector<uint8_t>& out, size_t position, uint64_t value);
+
+  /// @brief Reads a 64-bit little-endian integer.
+  static uint64_t read_u64(const uint8_t* data);
+};
+
+#endif  // CONTAINER_HPP
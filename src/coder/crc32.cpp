@@ -0,0 +1,43 @@
+#include "crc32.hpp"
+
+#include <array>
+
+namespace {
+
+using crc_tables = std::array<std::array<uint32_t, 256>, 8>;
+
+// tables[0] is the classic byte-at-a-time table, tables[k][byte] is the CRC of byte followed by k zero bytes.
+crc_tables build_tables() {
+  crc_tables tables;
+  for (uint32_t byte = 0; byte < 256; ++byte) {
+    uint32_t crc = byte;
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    tables[0][byte] = crc;
+  }
+  for (size_t k = 1; k < 8; ++k) {
+    for (size_t byte = 0; byte < 256; ++byte) {
+      tables[k][byte] = (tables[k - 1][byte] >> 8) ^ tables[0][tables[k - 1][byte] & 0xFFu];
+    }
+  }
+  return tables;
+}
+
+const crc_tables TABLES = build_tables();
+
+}  // namespace
+
+uint32_t crc32::compute(const uint8_t* data, size_t size, uint32_t crc) {
+  crc = ~crc;
+  for (; size >= 8; data += 8, size -= 8) {
+    const uint32_t low = crc ^ (uint32_t{data[0]} | uint32_t{data[1]} << 8 | uint32_t{data[2]} << 16 |
+                                uint32_t{data[3]} << 24);
+    crc = TABLES[7][low & 0xFFu] ^ TABLES[6][(low >> 8) & 0xFFu] ^ TABLES[5][(low >> 16) & 0xFFu] ^
+          TABLES[4][low >> 24] ^ TABLES[3][data[4]] ^ TABLES[2][data[5]] ^ TABLES[1][data[6]] ^ TABLES[0][data[7]];
+  }
+  for (; size > 0; ++data, --size) {
+    crc = (crc >> 8) ^ TABLES[0][(crc ^ *data) & 0xFFu];
+  }
+  return ~crc;
+}
@@ -0,0 +1,18 @@
+#ifndef CRC32_HPP
+#define CRC32_HPP
+#include <cstddef>
+#include <cstdint>
+
+/// @brief CRC-32 (the one used by zlib and PNG: reflected, polynomial 0xEDB88320) computed eight bytes at a time
+/// ("slicing-by-8"), fast enough that verifying block checksums costs little next to decoding them.
+class crc32 {
+ public:
+  /// @brief Computes the checksum of a range, optionally continuing a previous one.
+  /// @param data Pointer to the first byte.
+  /// @param size Number of bytes.
+  /// @param crc Checksum of the preceding data, 0 to start a new one.
+  /// @return Checksum of everything so far.
+  static uint32_t compute(const uint8_t* data, size_t size, uint32_t crc = 0);
+};
+
+#endif  // CRC32_HPP
@@ -2,28 +2,222 @@
 
 #include <fmt/core.h>
 
+#include <algorithm>
+#include <array>
 #include <bitset>
 #include <cmath>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <stdexcept>
 
-#include "../huffman/huffman.hpp"
+#include "parallel.hpp"
 
-decoder::decoder() {}
+namespace {
+
+// Flattened Huffman tree: each node holds two child references, which are either indices of other nodes or leaves
+// (LEAF_FLAG | byte). Children that no code leads to are INVALID_CHILD, which is a leaf as well, so the decoding loop
+// only has to tell it apart when it emits a byte.
+const uint32_t LEAF_FLAG = 1u << 31;
+const uint32_t INVALID_CHILD = UINT32_MAX;
+
+// Smallest part of the encoded data (in bytes) that is worth a decoding thread of its own.
+const uint64_t MIN_PARTITION_SIZE = 1u << 20;
+
+// Number of code boundaries a speculative decode remembers. Huffman codes typically fall into step with the true
+// boundaries within a few dozen codes.
+const size_t MAX_SPECULATIVE_BOUNDARIES = 4096;
+
+using flat_tree = std::vector<std::array<uint32_t, 2>>;
+
+flat_tree build_flat_tree(const std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>>& codebook) {
+  flat_tree tree(1, {INVALID_CHILD, INVALID_CHILD});
+  for (const auto& [original_byte, entry] : codebook) {
+    const auto& [length, code] = entry;
+    uint32_t node = 0;
+    for (uint8_t pos = 0; pos < length; ++pos) {
+      uint32_t& child = tree[node][code[pos]];
+      if (pos + 1u == length) {
+        if (child != INVALID_CHILD) {
+          throw std::runtime_error("Error: corrupted codebook (codes are not prefix-free)");
+        }
+        child = LEAF_FLAG | original_byte;
+      } else if (child == INVALID_CHILD) {
+        child = static_cast<uint32_t>(tree.size());
+        node = child;
+        tree.push_back({INVALID_CHILD, INVALID_CHILD});
+      } else if (child & LEAF_FLAG) {
+        throw std::runtime_error("Error: corrupted codebook (codes are not prefix-free)");
+      } else {
+        node = child;
+      }
+    }
+  }
+  return tree;
+}
+
+void validate_kraft_inequality(const std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>>& codebook) {
+  std::array<uint16_t, 256> length_counts{};
+  for (const auto& [original_byte, entry] : codebook) {
+    ++length_counts[entry.first];
+  }
+  // Number of unused codes of the current length; once it reaches 256 no set of at most 256 codes can exhaust it.
+  uint32_t free_codes = 1;
+  for (size_t length = 1; length < 256 && free_codes < 256; ++length) {
+    free_codes *= 2;
+    if (length_counts[length] > free_codes) {
+      throw std::runtime_error("Error: corrupted codebook (Kraft inequality violated)");
+    }
+    free_codes -= length_counts[length];
+  }
+}
+
+enum class walk_result { ok, invalid_code, truncated };
+
+void throw_walk_error(walk_result result) {
+  if (result == walk_result::invalid_code) {
+    throw std::runtime_error("Error: corrupted data (invalid code)");
+  }
+  throw std::runtime_error("Error: corrupted data (encoded data ends in the middle of a code)");
+}
+
+// Decodes codes from bit up to the first code boundary at or after stop (or the end of the data) and leaves bit
+// there. If boundaries is given, it receives the offsets of the first codes: boundaries[k] is where the code of the
+// k-th appended byte starts, the offset after the last code is included.
+walk_result walk(const flat_tree& tree, const uint8_t* encoded, uint64_t total_bits, uint64_t& bit, uint64_t stop,
+                 std::vector<uint8_t>& out, std::vector<uint64_t>* boundaries) {
+  uint32_t node = 0;
+  if (boundaries) boundaries->push_back(bit);
+  auto step = [&]() {
+    const uint32_t next = tree[node][(encoded[bit >> 3] >> (bit & 7u)) & 1u];
+    ++bit;
+    if (next & LEAF_FLAG) {
+      if (next == INVALID_CHILD) return false;
+      out.push_back(static_cast<uint8_t>(next));
+      node = 0;
+      if (boundaries && boundaries->size() < MAX_SPECULATIVE_BOUNDARIES) boundaries->push_back(bit);
+    } else {
+      node = next;
+    }
+    return true;
+  };
+  // Before stop there's no need to check for a code boundary, only the last code may go past it.
+  const uint64_t unchecked_end = std::min(stop, total_bits);
+  while (bit < unchecked_end) {
+    if (!step()) return walk_result::invalid_code;
+  }
+  while (bit < total_bits && node != 0) {
+    if (!step()) return walk_result::invalid_code;
+  }
+  return node == 0 ? walk_result::ok : walk_result::truncated;
+}
+
+// Part of the encoded data decoded by one thread, starting at a byte boundary that may be in the middle of a code.
+struct partition {
+  uint64_t start_bit;
+  uint64_t stop_bit;
+  uint64_t end_bit;
+  walk_result result;
+  std::vector<uint8_t> decoded_data;
+  std::vector<uint64_t> boundaries;
+};
+
+std::vector<uint8_t> decode_speculatively(const flat_tree& tree, const uint8_t* encoded, uint64_t encoded_bytes,
+                                          uint64_t total_bits, uint8_t shortest_code, unsigned threads) {
+  std::vector<partition> partitions(threads);
+  for (unsigned i = 0; i < threads; ++i) {
+    partitions[i].start_bit = encoded_bytes * i / threads * 8u;
+    partitions[i].stop_bit = i + 1u < threads ? encoded_bytes * (i + 1u) / threads * 8u : total_bits;
+  }
+
+  // Speculative pass: every partition but the first one may start in the middle of a code and decode garbage until
+  // it falls into step with the true code boundaries, its boundaries are kept to find that point later.
+  parallel::for_each(threads, threads, [&](size_t i) {
+    partition& part = partitions[i];
+    part.decoded_data.reserve((part.stop_bit - part.start_bit) / shortest_code);
+    part.end_bit = part.start_bit;
+    part.result = walk(tree, encoded, total_bits, part.end_bit, part.stop_bit, part.decoded_data,
+                       i > 0 ? &part.boundaries : nullptr);
+  });
+
+  // Sequential pass: continue from the true boundary where the previous partition ended until reaching one of this
+  // partition's boundaries, from there on its speculative output is exact.
+  size_t total_decoded_bytes = 0;
+  for (const auto& part : partitions) {
+    total_decoded_bytes += part.decoded_data.size();
+  }
+  std::vector<uint8_t> decoded_data;
+  decoded_data.reserve(total_decoded_bytes);
+  uint64_t bit = 0;
+  for (auto& part : partitions) {
+    bool synchronized = false;
+    if (part.result == walk_result::ok) {
+      while (!synchronized) {
+        if (bit >= part.stop_bit) {
+          synchronized = true;
+          break;
+        }
+        const auto boundary = std::lower_bound(part.boundaries.begin(), part.boundaries.end(), bit);
+        if (part.start_bit == 0 || (boundary != part.boundaries.end() && *boundary == bit)) {
+          const auto skipped = part.start_bit == 0 ? 0 : boundary - part.boundaries.begin();
+          decoded_data.insert(decoded_data.end(), part.decoded_data.begin() + skipped, part.decoded_data.end());
+          bit = part.end_bit;
+          synchronized = true;
+        } else if (boundary == part.boundaries.end()) {
+          break;
+        } else {
+          const walk_result result = walk(tree, encoded, total_bits, bit, bit + 1u, decoded_data, nullptr);
+          if (result != walk_result::ok) throw_walk_error(result);
+        }
+      }
+    }
+    if (!synchronized) {
+      const walk_result result = walk(tree, encoded, total_bits, bit, part.stop_bit, decoded_data, nullptr);
+      if (result != walk_result::ok) throw_walk_error(result);
+    }
+    std::vector<uint8_t>().swap(part.decoded_data);
+  }
+  return decoded_data;
+}
+
+}  // namespace
+
+decoder::decoder() : decoder(1) {}
+
+decoder::decoder(unsigned threads) : m_threads(std::max(threads, 1u)) {}
 
 std::vector<uint8_t> decoder::decode_data(const std::vector<uint8_t>& data) {
+  return decode_data(data.data(), data.size());
+}
+
+std::vector<uint8_t> decoder::decode_data(const uint8_t* data, size_t size) {
+  if (size < 2) {
+    throw std::runtime_error("Error: corrupted data (too short to hold a codebook)");
+  }
   uint32_t total_codes = data[0] + 1u;
   const uint32_t CODEBOOK_START = 1;
 
-  // Reading codebook
+  // Reading codebook, every field is bounds-checked since the input may come from anywhere
 
   std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>> codebook;
 
-  auto iterator = data.begin() + CODEBOOK_START;
+  const uint8_t* iterator = data + CODEBOOK_START;
+  auto require = [data, size, &iterator](size_t bytes) {
+    if (static_cast<size_t>(data + size - iterator) < bytes) {
+      throw std::runtime_error("Error: corrupted data (codebook is truncated)");
+    }
+  };
   for (uint32_t i = 0; i < total_codes; ++i) {
+    require(2);
     uint8_t original_byte = *(iterator++);
     uint8_t length = *(iterator++);
+    if (length == 0) {
+      throw std::runtime_error("Error: corrupted codebook (empty code)");
+    }
+    if (codebook.count(original_byte)) {
+      throw std::runtime_error("Error: corrupted codebook (duplicate byte)");
+    }
+    require((length + 7u) / 8u);
     std::bitset<255> code;
     uint8_t code_pos = 0;
 
@@ -43,34 +237,72 @@ std::vector<uint8_t> decoder::decode_data(const std::vector<uint8_t>& data) {
 
     codebook[original_byte] = std::pair<uint8_t, std::bitset<255>>(length, code);
   }
+  require(1);  // padding_bits
+
+  validate_kraft_inequality(codebook);
 
-  // Building Huffman tree
+  // Building flattened Huffman tree, fails on codes that are not prefix-free
 
-  const auto root = huffman::build_tree_from_codebook(codebook);
+  const auto tree = build_flat_tree(codebook);
 
   // Reading data
 
-  std::uint8_t padding_bits = data.back();
+  std::uint8_t padding_bits = data[size - 1u];
+  uint64_t encoded_data_start_index = static_cast<uint64_t>(iterator - data);
+  uint64_t encoded_data_bytes = size - encoded_data_start_index - 1u;
+  if (padding_bits > 7 || (encoded_data_bytes == 0 && padding_bits > 0)) {
+    throw std::runtime_error("Error: corrupted data (invalid padding)");
+  }
+  uint64_t total_encoded_bits = 8u * encoded_data_bytes - padding_bits;
 
   std::vector<uint8_t> decoded_data;
   {
-    auto tree_pointer = root;
-    uint64_t encoded_data_start_index = iterator - data.begin();
-    uint64_t total_encoded_bits = 8u * (data.size() - encoded_data_start_index - 1u) - padding_bits;
-
-    for (uint64_t current_bit_offset = 0; current_bit_offset < total_encoded_bits; ++current_bit_offset) {
-      uint8_t in_byte_pos = current_bit_offset % 8u;
-      bool bit = (data[encoded_data_start_index + current_bit_offset / 8u] & (1u << in_byte_pos));
-      if (bit) {
-        tree_pointer = tree_pointer->right_child;
+    uint8_t shortest_code = UINT8_MAX;
+    for (const auto& [original_byte, entry] : codebook) {
+      shortest_code = std::min(shortest_code, entry.first);
+    }
+    if (m_threads > 1 && encoded_data_bytes >= 2u * MIN_PARTITION_SIZE) {
+      const auto threads =
+          static_cast<unsigned>(std::min<uint64_t>(m_threads, encoded_data_bytes / MIN_PARTITION_SIZE));
+      return decode_speculatively(tree, data + encoded_data_start_index, encoded_data_bytes,
+                                  total_encoded_bits, shortest_code, threads);
+    }
+    decoded_data.reserve(total_encoded_bits / shortest_code);
+
+    uint32_t node = 0;
+    auto step = [&tree, &node, &decoded_data](bool bit) {
+      const uint32_t next = tree[node][bit];
+      if (next & LEAF_FLAG) {
+        if (next == INVALID_CHILD) {
+          throw std::runtime_error("Error: corrupted data (invalid code)");
+        }
+        decoded_data.push_back(static_cast<uint8_t>(next));
+        node = 0;
       } else {
-        tree_pointer = tree_pointer->left_child;
+        node = next;
       }
-      if (tree_pointer->left_child == nullptr && tree_pointer->right_child == nullptr) {
-        decoded_data.push_back(tree_pointer->byte);
-        tree_pointer = root;
+    };
+
+    // Fast loop: every byte but the last one carries 8 data bits, the loop bound is the only check needed.
+    const uint8_t* encoded = data + encoded_data_start_index;
+    const uint8_t* encoded_full_end = encoded + (encoded_data_bytes > 0 ? encoded_data_bytes - 1u : 0u);
+    for (; encoded < encoded_full_end; ++encoded) {
+      const uint8_t byte = *encoded;
+      for (uint8_t bit = 0; bit < 8; ++bit) {
+        step((byte >> bit) & 1u);
       }
     }
+
+    // Tail: the last byte holds only 8 - padding_bits data bits.
+    if (encoded_data_bytes > 0) {
+      const uint8_t byte = *encoded;
+      for (uint8_t bit = 0; bit < 8u - padding_bits; ++bit) {
+        step((byte >> bit) & 1u);
+      }
+    }
+    if (node != 0) {
+      throw std::runtime_error("Error: corrupted data (encoded data ends in the middle of a code)");
+    }
   }
   return decoded_data;
 }
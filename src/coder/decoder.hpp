@@ -1,21 +1,37 @@
 #ifndef DECODER_HPP
 #define DECODER_HPP
 #include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <vector>
 
-/// @brief Basic decoder.
+/// @brief Basic decoder. Large inputs may be decoded by several threads: each thread starts at a guessed position
+/// and relies on Huffman codes being self-synchronizing, then a short sequential pass finds where every guess meets
+/// the true code boundaries and re-decodes the parts that never did.
 class decoder {
  public:
   decoder();
 
+  /// @brief Constructs a decoder.
+  /// @param threads Maximum number of decoding threads, at least 1.
+  explicit decoder(unsigned threads);
+
   /// @brief {total_codes:uint8_t}[length(code[i]):uint8_t][code:[...uint8_t]][!encoded_data!][padding_bits:uint8_t] -
   /// total_codes from 0 to 255, but there's at least 1 code, so decoder need to add 1 to the total_codes to get the
   /// actual number of codes.
   /// @param data
   /// @return
   std::vector<uint8_t> decode_data(const std::vector<uint8_t>& data);
+
+  /// @brief Same as above, for data that isn't held in a vector (e.g. one member of a multi-member file).
+  /// @param data Pointer to the first byte.
+  /// @param size Number of bytes.
+  /// @return Decoded bytes.
+  std::vector<uint8_t> decode_data(const uint8_t* data, size_t size);
+
+ private:
+  unsigned m_threads;
 };
 
 #endif  // DECODER_HPP
\ No newline at end of file
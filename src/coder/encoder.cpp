@@ -1,10 +1,37 @@
 #include "encoder.hpp"
 
+#include <array>
+#include <stdexcept>
+
+#include "../huffman/huffman.hpp"
+
 encoder::encoder() {}
 
 std::vector<uint8_t> encoder::encode_data_with_codebook(
     const std::vector<uint8_t>& data, const std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>>& codebook) {
+  return encode_data_with_codebook(data.data(), data.size(), codebook);
+}
+
+std::vector<uint8_t> encoder::encode_data_with_codebook(
+    const uint8_t* data, size_t size, const std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>>& codebook) {
+  // Flat lookup instead of two map lookups per byte, and the exact output size from the byte frequencies
+  std::array<const std::pair<uint8_t, std::bitset<255>>*, 256> entries{};
+  uint64_t total_bits = 0;
+  {
+    std::array<uint64_t, 256> frequencies{};
+    huffman::count_frequencies(data, size, frequencies);
+    for (const auto& [original_byte, entry] : codebook) {
+      entries[original_byte] = &entry;
+      total_bits += 16u + (entry.first + 7u) / 8u * 8u + frequencies[original_byte] * entry.first;
+    }
+    for (size_t byte = 0; byte < 256; ++byte) {
+      if (frequencies[byte] > 0 && entries[byte] == nullptr) {
+        throw std::out_of_range("Error: codebook has no code for a byte of the data");
+      }
+    }
+  }
   std::vector<uint8_t> encoded_data;
+  encoded_data.reserve(1u + (total_bits + 7u) / 8u + 1u);
 
   // total_codes
   encoded_data.push_back(static_cast<uint8_t>(codebook.size() - 1u));
@@ -40,9 +67,9 @@ std::vector<uint8_t> encoder::encode_data_with_codebook(
   }
 
   uint8_t byte_pos = 8;
-  for (const auto& byte : data) {
-    const auto& code = codebook.at(byte).second;
-    const auto length = codebook.at(byte).first;
+  for (size_t byte_idx = 0; byte_idx < size; ++byte_idx) {
+    const auto& code = entries[data[byte_idx]]->second;
+    const auto length = entries[data[byte_idx]]->first;
 
     for (uint8_t i = 0; i < length; ++i) {
       const bool bit_value = code.test(i);
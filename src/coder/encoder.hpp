@@ -1,6 +1,7 @@
 #ifndef ENCODER_HPP
 #define ENCODER_HPP
 #include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <vector>
@@ -19,6 +20,15 @@ class encoder {
   /// @return
   std::vector<uint8_t> encode_data_with_codebook(
       const std::vector<uint8_t>& data, const std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>>& codebook);
+
+  /// @brief Same as above, but for borrowed data (e.g. a memory-mapped file). The result is allocated at its exact
+  /// size up front, so encoding never holds more than the input plus the output.
+  /// @param data Pointer to the first byte.
+  /// @param size Number of bytes.
+  /// @param codebook
+  /// @return
+  std::vector<uint8_t> encode_data_with_codebook(
+      const uint8_t* data, size_t size, const std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>>& codebook);
 };
 
 #endif  // ENCODER_HPP
\ No newline at end of file
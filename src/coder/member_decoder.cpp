@@ -0,0 +1,37 @@
+#include "member_decoder.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "chunk_walker.hpp"
+#include "container.hpp"
+#include "decoder.hpp"
+#include "stream_decoder.hpp"
+
+member_decoder::member_decoder(unsigned threads) : m_threads(threads) {}
+
+void member_decoder::decode(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+  if (!container::has_header(data, size)) {
+    decoder basic_decoder(m_threads);
+    std::vector<uint8_t> decoded_data = basic_decoder.decode_data(data, size);
+    if (out.empty()) {
+      out = std::move(decoded_data);
+    } else {
+      out.insert(out.end(), decoded_data.begin(), decoded_data.end());
+    }
+    return;
+  }
+  switch (container::read_mode(data)) {
+    case container::mode::adaptive:
+    case container::mode::block:
+      chunk_walker::decode(data, size, out);
+      break;
+    case container::mode::stream: {
+      stream_decoder stream_decoding(m_threads);
+      stream_decoding.decode(data + container::HEADER_SIZE, size - container::HEADER_SIZE, out);
+      break;
+    }
+    case container::mode::member:
+      throw std::runtime_error("Error: corrupted data (member frames can't be nested)");
+  }
+}
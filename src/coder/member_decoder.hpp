@@ -0,0 +1,26 @@
+#ifndef MEMBER_DECODER_HPP
+#define MEMBER_DECODER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Decodes one member of a multi-member file held in memory: the complete output of any coding mode (or of
+/// the basic format), without its member frame. Every member is decoded from a fresh state, since members are coded
+/// independently.
+class member_decoder {
+ public:
+  /// @brief Constructs a decoder.
+  /// @param threads Maximum number of threads for the coders that decode in parallel, at least 1.
+  explicit member_decoder(unsigned threads);
+
+  /// @brief Decodes a member. Throws std::runtime_error if it's malformed or has trailing bytes.
+  /// @param data Pointer to the first byte of the member.
+  /// @param size Number of bytes.
+  /// @param out Vector to append the decoded data to.
+  void decode(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+ private:
+  unsigned m_threads;
+};
+
+#endif  // MEMBER_DECODER_HPP
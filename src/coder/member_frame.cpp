@@ -0,0 +1,40 @@
+#include "member_frame.hpp"
+
+#include <fmt/core.h>
+
+#include <stdexcept>
+
+void member_frame::write_header(std::vector<uint8_t>& out, uint64_t member_size) {
+  container::write_header(out, container::mode::member);
+  container::write_u64(out, member_size);
+}
+
+std::vector<member_frame::member> member_frame::find_members(const uint8_t* data, size_t size) {
+  std::vector<member> members;
+  size_t position = 0;
+  while (position < size) {
+    const size_t remaining = size - position;
+    if (!container::has_header(data + position, remaining) ||
+        container::read_mode(data + position) != container::mode::member) {
+      throw std::runtime_error(fmt::format("Error: corrupted data (no member frame at byte {})", position));
+    }
+    if (remaining < FRAME_HEADER_SIZE) {
+      throw std::runtime_error("Error: corrupted data (member frame is truncated)");
+    }
+    const uint64_t member_size = container::read_u64(data + position + container::HEADER_SIZE);
+    if (member_size == 0) {
+      throw std::runtime_error(fmt::format("Error: corrupted data (member {} is empty)", members.size()));
+    }
+    if (member_size > remaining - FRAME_HEADER_SIZE) {
+      throw std::runtime_error(fmt::format("Error: corrupted data (member {} is truncated)", members.size()));
+    }
+    const size_t offset = position + FRAME_HEADER_SIZE;
+    if (container::has_header(data + offset, member_size) &&
+        container::read_mode(data + offset) == container::mode::member) {
+      throw std::runtime_error("Error: corrupted data (member frames can't be nested)");
+    }
+    members.push_back({offset, static_cast<size_t>(member_size)});
+    position = offset + static_cast<size_t>(member_size);
+  }
+  return members;
+}
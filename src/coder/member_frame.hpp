@@ -0,0 +1,36 @@
+#ifndef MEMBER_FRAME_HPP
+#define MEMBER_FRAME_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "container.hpp"
+
+/// @brief Frame that makes outputs concatenable: [header (member mode)]{member_size:uint64_t}[member], where the
+/// member is the complete output of any other mode or of the basic format. Frames appended one after another (e.g.
+/// by a log shipper) form a multi-member file, whose members can be found without decoding any of them.
+class member_frame {
+ public:
+  /// @brief Size of the container header and the member size.
+  static constexpr size_t FRAME_HEADER_SIZE = container::HEADER_SIZE + sizeof(uint64_t);
+
+  /// @brief Location of a member within a multi-member file.
+  struct member {
+    size_t offset;
+    size_t size;
+  };
+
+  /// @brief Appends a frame header.
+  /// @param out Vector to append to.
+  /// @param member_size Size of the member that follows.
+  static void write_header(std::vector<uint8_t>& out, uint64_t member_size);
+
+  /// @brief Finds the members of a multi-member file. Throws std::runtime_error if a frame is malformed, if a member
+  /// is empty, truncated or framed itself, or if anything but frames follows the first one.
+  /// @param data Pointer to the first byte of the file.
+  /// @param size Number of bytes.
+  /// @return Members in file order.
+  static std::vector<member> find_members(const uint8_t* data, size_t size);
+};
+
+#endif  // MEMBER_FRAME_HPP
@@ -0,0 +1,48 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/// @brief Minimal fork-join helper shared by the multi-threaded coders.
+class parallel {
+ public:
+  /// @brief Calls task(i) for every i in [0, count) on up to threads threads, the calling thread included. Indices
+  /// are handed out in increasing order, one at a time. Once every thread is done, the first exception thrown by a
+  /// task (if any) is rethrown; the remaining indices are skipped after a failure.
+  /// @param threads Maximum number of threads, 0 and 1 run everything on the calling thread.
+  /// @param count Number of indices.
+  /// @param task Callable taking a size_t.
+  template <typename Task>
+  static void for_each(unsigned threads, size_t count, const Task& task) {
+    std::atomic<size_t> next_index{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::atomic_flag error_taken = ATOMIC_FLAG_INIT;
+    auto work = [&]() {
+      for (size_t i = next_index++; i < count && !failed; i = next_index++) {
+        try {
+          task(i);
+        } catch (...) {
+          failed = true;
+          if (!error_taken.test_and_set()) error = std::current_exception();
+        }
+      }
+    };
+    std::vector<std::thread> workers;
+    const size_t extra_threads = std::min<size_t>(std::max(threads, 1u), count) - (count > 0 ? 1u : 0u);
+    for (size_t t = 0; t < extra_threads; ++t) {
+      workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    if (error) std::rethrow_exception(error);
+  }
+};
+
+#endif  // PARALLEL_HPP
@@ -0,0 +1,91 @@
+#include "stream_decoder.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../huffman/canonical_code.hpp"
+#include "container.hpp"
+#include "parallel.hpp"
+#include "table_coder.hpp"
+
+namespace {
+
+// Segment boundary: bit offset of a code in the encoded data and position of its byte in the output.
+struct sync_point {
+  uint64_t bit_offset;
+  uint64_t position;
+};
+
+}  // namespace
+
+stream_decoder::stream_decoder(unsigned threads)
+    : m_threads(std::max(threads, 1u)), m_sync_points(0), m_used_threads(0) {}
+
+void stream_decoder::decode(const uint8_t* encoded, size_t encoded_size, std::vector<uint8_t>& out) {
+  const size_t fixed_size = sizeof(uint64_t) + canonical_code::PACKED_LENGTHS_SIZE + sizeof(uint64_t);
+  if (encoded_size < fixed_size) {
+    throw std::runtime_error("Error: corrupted stream (header is truncated)");
+  }
+  const uint64_t raw_size = container::read_u64(encoded);
+  canonical_code code(canonical_code::read_lengths(encoded + sizeof(uint64_t)));
+  const uint64_t payload_size = container::read_u64(encoded + sizeof(uint64_t) + canonical_code::PACKED_LENGTHS_SIZE);
+  const uint8_t* payload = encoded + fixed_size;
+  encoded_size -= fixed_size;
+  if (payload_size > encoded_size || encoded_size - payload_size < sizeof(uint32_t)) {
+    throw std::runtime_error("Error: corrupted stream (encoded data is truncated)");
+  }
+  if (raw_size == 0 || raw_size > payload_size * 8u) {
+    throw std::runtime_error("Error: corrupted stream (invalid size)");
+  }
+
+  // Sync points, validated so that segments are non-empty and lie within the data
+  const uint8_t* table = payload + payload_size;
+  const uint32_t sync_points = container::read_u32(table);
+  table += sizeof(uint32_t);
+  if (encoded_size - payload_size - sizeof(uint32_t) != uint64_t{sync_points} * 2u * sizeof(uint64_t)) {
+    throw std::runtime_error("Error: corrupted stream (sync point table size mismatch)");
+  }
+  std::vector<sync_point> segments{{0, 0}};
+  segments.reserve(sync_points + 2u);
+  for (uint32_t i = 0; i < sync_points; ++i, table += 2u * sizeof(uint64_t)) {
+    const sync_point point{container::read_u64(table), container::read_u64(table + sizeof(uint64_t))};
+    if (point.bit_offset <= segments.back().bit_offset || point.bit_offset >= payload_size * 8u ||
+        point.position <= segments.back().position || point.position >= raw_size) {
+      throw std::runtime_error("Error: corrupted stream (invalid sync point)");
+    }
+    segments.push_back(point);
+  }
+  segments.push_back({payload_size * 8u, raw_size});
+  m_sync_points = sync_points;
+
+  code.build_decode_table();
+  const size_t output_start = out.size();
+  out.resize(output_start + static_cast<size_t>(raw_size));
+  uint8_t* destination = out.data() + output_start;
+
+  // Each thread takes a run of consecutive segments holding about the same number of output bytes. A segment has to
+  // end exactly at the next sync point, otherwise the sync point (or the data) is corrupted.
+  auto decode_segments = [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      const uint64_t end_bit =
+          table_coder::decode(code, payload, static_cast<size_t>(payload_size), segments[i].bit_offset,
+                              destination + segments[i].position,
+                              static_cast<size_t>(segments[i + 1].position - segments[i].position));
+      if (i + 2 < segments.size() && end_bit != segments[i + 1].bit_offset) {
+        throw std::runtime_error("Error: corrupted stream (sync point is not on a code boundary)");
+      }
+    }
+  };
+  const size_t total_segments = segments.size() - 1u;
+  const auto threads = static_cast<unsigned>(std::min<size_t>(m_threads, total_segments));
+  std::vector<size_t> first_segment(threads + 1u, total_segments);
+  for (unsigned t = 0; t < threads; ++t) {
+    const uint64_t position = raw_size / threads * t;
+    first_segment[t] = static_cast<size_t>(
+        std::lower_bound(segments.begin(), segments.end() - 1, position,
+                         [](const sync_point& point, uint64_t value) { return point.position < value; }) -
+        segments.begin());
+  }
+  m_used_threads = threads;
+  parallel::for_each(threads, threads, [&](size_t t) { decode_segments(first_segment[t], first_segment[t + 1]); });
+}
@@ -0,0 +1,35 @@
+#ifndef STREAM_DECODER_HPP
+#define STREAM_DECODER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Decoder for the streams produced by stream_encoder. The sync points split the stream into segments that
+/// are decoded by several threads straight into their place in the output. The container header is expected to be
+/// consumed by the caller.
+class stream_decoder {
+ public:
+  /// @brief Constructs a decoder.
+  /// @param threads Maximum number of decoding threads, at least 1.
+  explicit stream_decoder(unsigned threads);
+
+  /// @brief Decodes a whole stream. Throws std::runtime_error on malformed data, including sync points that don't
+  /// fall on the code boundaries they claim.
+  /// @param encoded Pointer to the first byte after the container header.
+  /// @param encoded_size Number of bytes after the container header.
+  /// @param out Vector to append the decoded data to.
+  void decode(const uint8_t* encoded, size_t encoded_size, std::vector<uint8_t>& out);
+
+  /// @brief Returns the number of sync points found by the last decode() call.
+  uint32_t get_sync_points() const { return m_sync_points; }
+
+  /// @brief Returns the number of threads used by the last decode() call.
+  unsigned get_used_threads() const { return m_used_threads; }
+
+ private:
+  unsigned m_threads;
+  uint32_t m_sync_points;
+  unsigned m_used_threads;
+};
+
+#endif  // STREAM_DECODER_HPP
@@ -0,0 +1,57 @@
+#include "stream_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+#include "../huffman/canonical_code.hpp"
+#include "../huffman/huffman.hpp"
+#include "bit_writer.hpp"
+#include "container.hpp"
+
+stream_encoder::stream_encoder(uint32_t sync_interval_kib)
+    : m_sync_interval_bits(uint64_t{sync_interval_kib} * 1024u * 8u), m_sync_points(0) {}
+
+void stream_encoder::encode(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+  if (size == 0) {
+    throw std::logic_error("Error: stream must not be empty");
+  }
+  std::array<uint64_t, 256> frequencies{};
+  huffman::count_frequencies(data, size, frequencies);
+  const canonical_code code(huffman::calculate_code_lengths(frequencies, canonical_code::MAX_CODE_LENGTH));
+  const auto& lengths = code.get_lengths();
+  const auto& codes = code.get_codes();
+  const uint64_t encoded_size = (code.calculate_encoded_bits(frequencies) + 7u) / 8u;
+
+  std::vector<std::pair<uint64_t, uint64_t>> sync_points;
+  const uint64_t max_sync_points = m_sync_interval_bits > 0 ? encoded_size * 8u / m_sync_interval_bits + 1u : 0u;
+  out.reserve(out.size() + container::HEADER_SIZE + 2u * sizeof(uint64_t) + canonical_code::PACKED_LENGTHS_SIZE +
+              encoded_size + sizeof(uint32_t) + max_sync_points * 2u * sizeof(uint64_t));
+  container::write_header(out, container::mode::stream);
+  container::write_u64(out, size);
+  code.write_lengths(out);
+  container::write_u64(out, encoded_size);
+  {
+    bit_writer writer(out);
+    uint64_t next_sync_bit = m_sync_interval_bits;
+    for (size_t i = 0; i < size; i += SYNC_GRANULARITY) {
+      if (m_sync_interval_bits > 0 && i > 0 && writer.bit_count() >= next_sync_bit) {
+        sync_points.emplace_back(writer.bit_count(), i);
+        next_sync_bit = writer.bit_count() + m_sync_interval_bits;
+      }
+      const size_t end = std::min(size, i + SYNC_GRANULARITY);
+      for (size_t j = i; j < end; ++j) {
+        writer.write(codes[data[j]], lengths[data[j]]);
+      }
+    }
+    writer.flush();
+  }
+
+  container::write_u32(out, static_cast<uint32_t>(sync_points.size()));
+  for (const auto& [bit_offset, position] : sync_points) {
+    container::write_u64(out, bit_offset);
+    container::write_u64(out, position);
+  }
+  m_sync_points = static_cast<uint32_t>(sync_points.size());
+}
@@ -0,0 +1,37 @@
+#ifndef STREAM_ENCODER_HPP
+#define STREAM_ENCODER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Encoder that codes the whole input as one stream with a single canonical code and records sync points: bit
+/// offsets where a code starts, along with the position of its byte in the input. A decoder can start at any sync
+/// point, so the stream can be split between threads.
+class stream_encoder {
+ public:
+  /// @brief Number of bytes encoded between two checks for a sync point; sync points are only placed there, which
+  /// keeps the check out of the per-byte loop.
+  static constexpr size_t SYNC_GRANULARITY = 4096;
+
+  /// @brief Constructs an encoder.
+  /// @param sync_interval_kib Distance between sync points in KiB of encoded data, 0 to record none.
+  explicit stream_encoder(uint32_t sync_interval_kib);
+
+  /// @brief [header]{raw_size:uint64_t}[lengths:128 x uint8_t]{encoded_size:uint64_t}[!encoded_data!]
+  /// {sync_points:uint32_t}[{bit_offset:uint64_t}{position:uint64_t}] - encodes the whole input. Bit offsets count
+  /// from the start of the encoded data, positions are strictly increasing and never 0 (the stream start is an
+  /// implicit sync point).
+  /// @param data Pointer to the first byte of the input.
+  /// @param size Number of bytes in the input, at least 1.
+  /// @param out Vector to append the encoded stream to.
+  void encode(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+  /// @brief Returns the number of sync points recorded by the last encode() call.
+  uint32_t get_sync_points() const { return m_sync_points; }
+
+ private:
+  uint64_t m_sync_interval_bits;
+  uint32_t m_sync_points;
+};
+
+#endif  // STREAM_ENCODER_HPP
@@ -0,0 +1,63 @@
+#include "table_coder.hpp"
+
+#include <stdexcept>
+
+#include "bit_reader.hpp"
+#include "bit_writer.hpp"
+
+void table_coder::encode(const canonical_code& code, const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+  const auto& lengths = code.get_lengths();
+  const auto& codes = code.get_codes();
+  bit_writer writer(out);
+  for (size_t i = 0; i < size; ++i) {
+    writer.write(codes[data[i]], lengths[data[i]]);
+  }
+  writer.flush();
+}
+
+void table_coder::decode(const canonical_code& code, const uint8_t* encoded, size_t encoded_size,
+                         uint8_t* destination, size_t raw_size) {
+  decode(code, encoded, encoded_size, 0, destination, raw_size);
+}
+
+uint64_t table_coder::decode(const canonical_code& code, const uint8_t* encoded, size_t encoded_size,
+                             uint64_t first_bit, uint8_t* destination, size_t raw_size) {
+  if (first_bit > uint64_t{encoded_size} * 8u) {
+    throw std::runtime_error("Error: corrupted data (code starts beyond the end of data)");
+  }
+  // Raw pointer: stores through destination may alias the vector internals, which would force a reload per byte.
+  const uint16_t* table = code.get_decode_table().data();
+  const uint8_t table_bits = code.get_max_length();
+  const size_t first_byte = static_cast<size_t>(first_bit / 8u);
+  bit_reader reader(encoded + first_byte, encoded_size - first_byte);
+  reader.skip_first_bits(static_cast<uint8_t>(first_bit % 8u));
+  size_t i = 0;
+
+  // Fast loop: with a complete code every table entry is valid and, while 8 bytes remain, refills need no bounds
+  // checks. 56 buffered bits always hold 3 codes of at most 15 bits.
+  if (code.is_complete()) {
+    while (raw_size - i >= 3 && reader.available_bytes() >= 8) {
+      reader.refill_fast();
+      for (uint8_t repeat = 0; repeat < 3; ++repeat) {
+        const uint16_t entry = table[reader.peek_buffered(table_bits)];
+        reader.consume(static_cast<uint8_t>(entry & 0xFu));
+        destination[i++] = static_cast<uint8_t>(entry >> 4);
+      }
+    }
+  }
+
+  // Checked loop for the tail (and for incomplete codes, where a table entry may be invalid).
+  for (; i < raw_size; ++i) {
+    const uint16_t entry = table[reader.peek(table_bits)];
+    const auto length = static_cast<uint8_t>(entry & 0xFu);
+    if (length == 0) {
+      throw std::runtime_error("Error: corrupted data (invalid code)");
+    }
+    reader.consume(length);
+    destination[i] = static_cast<uint8_t>(entry >> 4);
+  }
+  if (reader.overrun()) {
+    throw std::runtime_error("Error: corrupted data (encoded data is truncated)");
+  }
+  return first_byte * 8u + reader.bit_position();
+}
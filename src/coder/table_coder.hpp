@@ -0,0 +1,37 @@
+#ifndef TABLE_CODER_HPP
+#define TABLE_CODER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../huffman/canonical_code.hpp"
+
+/// @brief Table-driven coding of byte ranges with a canonical code, shared by the chunked coding modes.
+class table_coder {
+ public:
+  /// @brief Appends the encoded bytes to out, the last byte is padded with zero bits.
+  /// @param code Code that has a non-zero length for every byte in the range.
+  /// @param data Pointer to the first byte.
+  /// @param size Number of bytes.
+  /// @param out Vector to append the encoded data to.
+  static void encode(const canonical_code& code, const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+  /// @brief Decodes exactly raw_size bytes. Throws std::runtime_error if the data contains an invalid code or ends
+  /// prematurely.
+  /// @param code Code with a built decode table.
+  /// @param encoded Pointer to the encoded data.
+  /// @param encoded_size Size of the encoded data in bytes.
+  /// @param destination Buffer for raw_size decoded bytes.
+  /// @param raw_size Number of bytes to decode.
+  static void decode(const canonical_code& code, const uint8_t* encoded, size_t encoded_size, uint8_t* destination,
+                     size_t raw_size);
+
+  /// @brief Decodes exactly raw_size bytes starting in the middle of the encoded data, which lets several threads
+  /// decode one stream. Throws std::runtime_error like the overload above.
+  /// @param first_bit Bit offset of the first code, counted from encoded.
+  /// @return Bit offset right after the last decoded code.
+  static uint64_t decode(const canonical_code& code, const uint8_t* encoded, size_t encoded_size, uint64_t first_bit,
+                         uint8_t* destination, size_t raw_size);
+};
+
+#endif  // TABLE_CODER_HPP
@@ -4,27 +4,72 @@
 #include <fmt/ranges.h>
 
 #include <boost/filesystem.hpp>
+#include <cerrno>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
 
+#include "../coder/adaptive_encoder.hpp"
+#include "../coder/block_encoder.hpp"
+#include "../coder/block_planner.hpp"
 #include "../coder/encoder.hpp"
+#include "../coder/member_frame.hpp"
+#include "../coder/stream_encoder.hpp"
+#include "../huffman/canonical_code.hpp"
 #include "../huffman/huffman.hpp"
+#include "../profiler/profiler.hpp"
+
+#if __has_include(<poll.h>) && __has_include(<unistd.h>)
+#include <poll.h>
+#include <unistd.h>
+#endif
 
 namespace fs = boost::filesystem;
 
-void compression_coordinator::perform_compression(const std::string& input_, const std::string& output_,
-                                                  bool ignore_empty_, bool verbose_) {
-  if (verbose_) std::cout << "Validating options..." << std::endl;
-  validate_options(input_, output_);
-  if (verbose_) std::cout << "Validation passed!" << std::endl << std::endl;
+void compression_coordinator::perform_compression(const options& options_) {
+  profiler::stage stage("compress");
+  if (options_.verbose) std::cout << "Validating options..." << std::endl;
+  validate_options(options_);
+  if (options_.verbose) std::cout << "Validation passed!" << std::endl << std::endl;
 
-  this->input = input_;
-  this->output = output_;
-  this->ignore_empty = ignore_empty_;
-  this->verbose = verbose_;
+  this->input = options_.input;
+  this->output = options_.output;
+  this->ignore_empty = options_.ignore_empty;
+  this->verbose = options_.verbose;
+  this->adaptive_chunk_kib = options_.adaptive_chunk_kib;
+  this->block_size_kib = options_.block_size_kib;
+  this->code_reuse_tolerance = options_.code_reuse_tolerance.value_or(block_encoder::DEFAULT_REUSE_TOLERANCE_PERCENT);
+  this->max_memory_mib = options_.max_memory_mib;
+  this->sync_interval_kib = options_.sync_interval_kib;
+  this->level = options_.level;
+  this->plan_blocks = options_.plan_blocks;
+  this->threads = options_.threads;
+  this->frame = options_.frame;
+
+  // A level selects block mode with its preset settings, an explicit --block-size or --code-reuse-tolerance still wins
+  compression_level::settings block_settings{block_size_kib, code_reuse_tolerance, canonical_code::MAX_CODE_LENGTH,
+                                             0, false, plan_blocks};
+  if (level) {
+    block_settings = compression_level::get_settings(*level);
+    if (block_size_kib > 0) block_settings.block_size_kib = block_size_kib;
+    if (options_.code_reuse_tolerance) block_settings.code_reuse_tolerance = *options_.code_reuse_tolerance;
+    block_settings.plan_blocks = block_settings.plan_blocks || plan_blocks;
+    block_size_kib = block_settings.block_size_kib;
+    code_reuse_tolerance = block_settings.code_reuse_tolerance;
+    plan_blocks = block_settings.plan_blocks;
+  }
+  if (plan_blocks && block_size_kib < block_planner::SEGMENT_SIZE / 1024u) {
+    throw std::runtime_error(
+        fmt::format("Error: planned blocks can't be smaller than {} KiB", block_planner::SEGMENT_SIZE / 1024u));
+  }
+  if (plan_blocks && max_memory_mib > 0 && uint64_t{block_size_kib} * 1024u * 4u > max_memory_mib * 1024u * 1024u) {
+    throw std::runtime_error(fmt::format("Error: planned blocks of up to {} KiB don't fit into {} MiB, consider a "
+                                         "smaller --block-size or a larger --max-memory",
+                                         block_size_kib, max_memory_mib));
+  }
 
   if (verbose) {
     std::cout << "Your configuration:" << std::endl;
@@ -32,12 +77,70 @@ void compression_coordinator::perform_compression(const std::string& input_, con
     std::cout << "output source: " << output << std::endl;
     std::cout << "ignore empty data: " << std::boolalpha << ignore_empty << std::endl;
     std::cout << "verbose: " << std::boolalpha << verbose << std::endl;
+    if (level) {
+      std::cout << "level: " << compression_level::get_name(*level) << std::endl;
+      std::cout << "maximum code length: " << static_cast<int>(block_settings.max_code_length) << " bits"
+                << std::endl;
+      std::cout << "histogram sampling interval: " << block_settings.sampling_interval << std::endl;
+      std::cout << "block checksums: " << std::boolalpha << block_settings.checksum << std::endl;
+    }
+    if (adaptive_chunk_kib > 0) std::cout << "adaptive chunk size: " << adaptive_chunk_kib << " KiB" << std::endl;
+    if (block_size_kib > 0) {
+      std::cout << "block size: " << block_size_kib << " KiB" << std::endl;
+      std::cout << "code reuse tolerance: " << code_reuse_tolerance << "%" << std::endl;
+      std::cout << "planned blocks: " << std::boolalpha << plan_blocks << std::endl;
+    }
+    std::cout << "threads: " << threads << std::endl;
+    if (max_memory_mib > 0) std::cout << "max memory: " << max_memory_mib << " MiB" << std::endl;
+    if (sync_interval_kib > 0) std::cout << "sync interval: " << sync_interval_kib << " KiB" << std::endl;
+    std::cout << "member frame: " << std::boolalpha << frame << std::endl;
     std::cout << std::endl;
   }
 
-  std::vector<uint8_t> data = read_data_from_input();
-  if (verbose) std::cout << "Total data bytes: " << data.size() << std::endl << std::endl;
-  if (data.empty()) {
+  if (adaptive_chunk_kib == 0 && block_size_kib == 0 && sync_interval_kib == 0 && exceeds_max_memory()) {
+    // Block mode keeps a block and its encoded form (at most about twice as large) in memory
+    const uint64_t block_size = std::min<uint64_t>(max_memory_mib * 1024u * 1024u / 4u, block_encoder::MAX_BLOCK_SIZE);
+    block_size_kib = static_cast<uint32_t>(std::max<uint64_t>(block_size / 1024u, 64u));
+    if (verbose) {
+      std::cout << fmt::format("The input doesn't fit into {} MiB, switching to block mode with {} KiB blocks",
+                               max_memory_mib, block_size_kib)
+                << std::endl
+                << std::endl;
+    }
+  }
+
+  perform_coding(block_settings);
+  if (frame) finish_frame();
+}
+
+void compression_coordinator::perform_coding(const compression_level::settings& block_settings) {
+  if (adaptive_chunk_kib > 0) {
+    if (verbose) std::cout << "Encoding data adaptively..." << std::endl;
+    adaptive_encoder coder;
+    perform_chunked_compression(coder, size_t{adaptive_chunk_kib} * 1024u, true);
+    return;
+  }
+  if (block_size_kib > 0) {
+    if (verbose) std::cout << "Encoding data in blocks..." << std::endl;
+    block_encoder coder(code_reuse_tolerance, block_settings.max_code_length, block_settings.sampling_interval,
+                        block_settings.checksum);
+    if (plan_blocks) {
+      perform_planned_compression(coder, size_t{block_size_kib} * 1024u);
+    } else {
+      perform_chunked_compression(coder, size_t{block_size_kib} * 1024u, false);
+    }
+    if (verbose) {
+      std::cout << fmt::format("Blocks reusing the previous code: {}", coder.get_repeated_blocks()) << std::endl;
+      std::cout << fmt::format("Code cache hits: {}, misses: {}", coder.get_cache().get_hits(),
+                               coder.get_cache().get_misses())
+                << std::endl;
+    }
+    return;
+  }
+
+  read_data_from_input();
+  if (verbose) std::cout << "Total data bytes: " << input_size << std::endl << std::endl;
+  if (input_size == 0) {
     if (verbose) {
       std::cout << "Input data is empty!" << std::endl;
     }
@@ -48,26 +151,56 @@ void compression_coordinator::perform_compression(const std::string& input_, con
     }
   }
 
+  if (sync_interval_kib > 0) {
+    if (verbose) std::cout << "Encoding data as a single stream with sync points..." << std::endl;
+    stream_encoder coder(sync_interval_kib);
+    std::vector<uint8_t> encoded_data;
+    {
+      profiler::stage encode_stage("stream_encoder::encode");
+      coder.encode(input_data, input_size, encoded_data);
+    }
+    if (verbose) {
+      std::cout << fmt::format("Sync points: {}", coder.get_sync_points()) << std::endl;
+      std::cout << fmt::format("Encoded data size: {}", encoded_data.size()) << std::endl;
+      std::cout << fmt::format("Compressed {:.2f}%",
+                               100.0 * (static_cast<double>(input_size) - static_cast<double>(encoded_data.size())) /
+                                   static_cast<double>(input_size))
+                << std::endl;
+    }
+    if (verbose) std::cout << "Outputing data..." << std::endl;
+    output_encoded_data(encoded_data);
+    return;
+  }
+
   huffman algorithm;
   if (verbose) std::cout << "Initializing Huffman..." << std::endl;
-  algorithm.initialize_data(data);
+  algorithm.initialize_data(input_data, input_size);
 
   if (verbose) std::cout << "Calculating frequencies..." << std::endl;
-  algorithm.calculate_frequencies();
+  {
+    profiler::stage huffman_stage("huffman::calculate_frequencies");
+    algorithm.calculate_frequencies();
+  }
   if (verbose) {
     std::cout << "Frequencies (byte, frequency): " << fmt::format("{}", fmt::join(algorithm.get_frequencies(), ","))
               << std::endl;
   }
 
   if (verbose) std::cout << "Sorting frequencies..." << std::endl;
-  algorithm.sort_frequencies();
+  {
+    profiler::stage huffman_stage("huffman::sort_frequencies");
+    algorithm.sort_frequencies();
+  }
   if (verbose) {
     std::cout << "Sorted frequencies (byte, frequency): "
               << fmt::format("{}", fmt::join(algorithm.get_sorted_frequencies(), ",")) << std::endl;
   }
 
   if (verbose) std::cout << "Building Huffman tree..." << std::endl;
-  algorithm.build_tree();
+  {
+    profiler::stage huffman_stage("huffman::build_tree");
+    algorithm.build_tree();
+  }
   if (verbose) {
     std::cout << "Huffman tree:" << std::endl;
     auto root_copy = algorithm.get_tree_copy();
@@ -91,7 +224,10 @@ void compression_coordinator::perform_compression(const std::string& input_, con
   }
 
   if (verbose) std::cout << "Compiling codebook..." << std::endl;
-  algorithm.compile_codebook();
+  {
+    profiler::stage huffman_stage("huffman::compile_codebook");
+    algorithm.compile_codebook();
+  }
   if (verbose) {
     const auto& codebook = algorithm.get_codebook();
     auto subcode = [](const std::bitset<255>& bitset, uint8_t length) -> std::string {
@@ -112,12 +248,16 @@ void compression_coordinator::perform_compression(const std::string& input_, con
 
   if (verbose) std::cout << "Encoding data..." << std::endl;
   encoder coder;
-  std::vector<uint8_t> encoded_data = coder.encode_data_with_codebook(data, algorithm.get_codebook());
+  std::vector<uint8_t> encoded_data;
+  {
+    profiler::stage encode_stage("encoder::encode_data_with_codebook");
+    encoded_data = coder.encode_data_with_codebook(input_data, input_size, algorithm.get_codebook());
+  }
   if (verbose) {
     std::cout << fmt::format("Encoded data size: {}", encoded_data.size()) << std::endl;
     std::cout << fmt::format("Compressed {:.2f}%",
-                             100.0 * (static_cast<double>(data.size()) - static_cast<double>(encoded_data.size())) /
-                                 static_cast<double>(data.size()))
+                             100.0 * (static_cast<double>(input_size) - static_cast<double>(encoded_data.size())) /
+                                 static_cast<double>(input_size))
               << std::endl;
   }
 
@@ -125,48 +265,295 @@ void compression_coordinator::perform_compression(const std::string& input_, con
   output_encoded_data(encoded_data);
 }
 
-std::vector<uint8_t> compression_coordinator::read_data_from_input() {
-  std::vector<uint8_t> data;
-  if (input == "stdin") {
-    char c;
-    while (!std::cin.eof() && std::cin.get(c)) {
-      data.push_back(c);
+void compression_coordinator::perform_chunked_compression(chunk_encoder& coder, size_t chunk_size,
+                                                          bool encode_partial_chunks) {
+  std::ifstream input_file;
+  if (input != "stdin") input_file.open(input, std::ios::binary);
+  std::istream& in = input == "stdin" ? std::cin : input_file;
+  // Files never make a read wait, only stdin may deliver its data slowly
+  const bool read_partial_chunks = encode_partial_chunks && input == "stdin";
+
+  std::vector<uint8_t> chunk(chunk_size);
+  std::vector<uint8_t> encoded_data;
+  uint64_t total_data_bytes = 0;
+  uint64_t total_encoded_bytes = 0;
+  auto flush_encoded_data = [&]() {
+    profiler::stage write_stage("write output");
+    output_stream().write(reinterpret_cast<const char*>(encoded_data.data()),
+                          static_cast<std::streamsize>(encoded_data.size()));
+    output_stream().flush();
+    total_encoded_bytes += encoded_data.size();
+    encoded_data.clear();
+  };
+
+  auto read_chunk = [&]() {
+    profiler::stage read_stage("read input");
+    if (read_partial_chunks) return read_available_input(chunk.data(), chunk_size);
+    in.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk_size));
+    return static_cast<size_t>(in.gcount());
+  };
+
+  while (true) {
+    const size_t read_bytes = read_chunk();
+    if (read_bytes == 0) break;
+    if (total_data_bytes == 0) {
+      coder.encode_header(encoded_data);
+      flush_encoded_data();
+    }
+    {
+      profiler::stage encode_stage("chunk_encoder::encode_chunk");
+      coder.encode_chunk(chunk.data(), read_bytes, encoded_data);
+    }
+    total_data_bytes += read_bytes;
+    flush_encoded_data();
+  }
+
+  if (verbose) std::cout << "Total data bytes: " << total_data_bytes << std::endl << std::endl;
+  if (total_data_bytes == 0) {
+    if (verbose) {
+      std::cout << "Input data is empty!" << std::endl;
     }
-    data.pop_back();
+    if (ignore_empty) {
+      return;
+    } else {
+      throw std::runtime_error("Error: input data is empty, consider using --ignore-empty to exit peacefully with 0");
+    }
+  }
+
+  coder.encode_end(encoded_data);
+  flush_encoded_data();
+  if (verbose) {
+    std::cout << fmt::format("Encoded data size: {}", total_encoded_bytes) << std::endl;
+    std::cout << fmt::format("Compressed {:.2f}%", 100.0 *
+                                                       (static_cast<double>(total_data_bytes) -
+                                                        static_cast<double>(total_encoded_bytes)) /
+                                                       static_cast<double>(total_data_bytes))
+              << std::endl;
+  }
+}
+
+void compression_coordinator::perform_planned_compression(block_encoder& coder, size_t max_block_size) {
+  // Planned and encoded a batch at a time, which bounds the memory taken by the encoded blocks. Under a memory limit
+  // the input is read a batch at a time as well, with batches of a quarter of the limit: the batch, its blocks
+  // encoded in parallel and the encoded batch (each at most about as large) have to fit into it
+  const bool stream_input = max_memory_mib > 0;
+  size_t batch_size = PLANNING_BATCH_SIZE;
+  if (stream_input) batch_size = std::min<uint64_t>(batch_size, max_memory_mib * 1024u * 1024u / 4u);
+  batch_size = std::max<size_t>(batch_size / max_block_size, 1u) * max_block_size;
+
+  std::ifstream input_file;
+  std::vector<uint8_t> batch;
+  size_t offset = 0;
+  if (stream_input) {
+    if (input != "stdin") input_file.open(input, std::ios::binary);
+    batch.resize(batch_size);
   } else {
-    std::ifstream file(input);
-    file.seekg(0, std::ios::end);
-    if (file.tellg() > 0) {
-      file.clear();
-      file.seekg(0, std::ios::beg);
-      char c;
-      while (!file.eof() && file.get(c)) {
-        data.push_back(c);
+    read_data_from_input();
+  }
+  std::istream& in = input == "stdin" ? std::cin : input_file;
+  auto next_batch = [&](const uint8_t*& data) {
+    if (!stream_input) {
+      data = input_data + offset;
+      const size_t size = std::min(batch_size, input_size - offset);
+      offset += size;
+      return size;
+    }
+    profiler::stage read_stage("read input");
+    in.read(reinterpret_cast<char*>(batch.data()), static_cast<std::streamsize>(batch_size));
+    data = batch.data();
+    return static_cast<size_t>(in.gcount());
+  };
+
+  block_planner planner(max_block_size);
+  std::vector<uint8_t> encoded_data;
+  uint64_t total_data_bytes = 0;
+  uint64_t total_encoded_bytes = 0;
+  uint64_t total_blocks = 0;
+  while (true) {
+    const uint8_t* data = nullptr;
+    const size_t size = next_batch(data);
+    if (size == 0) break;
+    if (total_data_bytes == 0) coder.encode_header(encoded_data);
+    std::vector<size_t> block_sizes;
+    {
+      profiler::stage plan_stage("block_planner::plan");
+      block_sizes = planner.plan(data, size, threads);
+    }
+    {
+      profiler::stage encode_stage("block_encoder::encode_blocks");
+      coder.encode_blocks(data, block_sizes, threads, encoded_data);
+    }
+    total_data_bytes += size;
+    total_blocks += block_sizes.size();
+    output_encoded_data(encoded_data);
+    output_stream().flush();
+    total_encoded_bytes += encoded_data.size();
+    std::vector<uint8_t>().swap(encoded_data);
+  }
+
+  if (verbose) std::cout << "Total data bytes: " << total_data_bytes << std::endl << std::endl;
+  if (total_data_bytes == 0) {
+    if (verbose) {
+      std::cout << "Input data is empty!" << std::endl;
+    }
+    if (ignore_empty) {
+      return;
+    } else {
+      throw std::runtime_error("Error: input data is empty, consider using --ignore-empty to exit peacefully with 0");
+    }
+  }
+
+  coder.encode_end(encoded_data);
+  output_encoded_data(encoded_data);
+  output_stream().flush();
+  total_encoded_bytes += encoded_data.size();
+  if (verbose) {
+    std::cout << fmt::format("Planned blocks: {}", total_blocks) << std::endl;
+    std::cout << fmt::format("Encoded data size: {}", total_encoded_bytes) << std::endl;
+    std::cout << fmt::format("Compressed {:.2f}%", 100.0 *
+                                                       (static_cast<double>(total_data_bytes) -
+                                                        static_cast<double>(total_encoded_bytes)) /
+                                                       static_cast<double>(total_data_bytes))
+              << std::endl;
+  }
+}
+
+uint64_t compression_coordinator::estimate_peak_memory(uint64_t input_size_) {
+  // Input plus encoded output; the codebook is at most 256 * (2 + 32) bytes
+  return 2u * input_size_ + 256u * 34u;
+}
+
+bool compression_coordinator::exceeds_max_memory() {
+  if (max_memory_mib == 0) {
+    return false;
+  }
+  if (input == "stdin") {
+    return true;  // the size isn't known in advance, so only streaming is safe
+  }
+  return estimate_peak_memory(fs::file_size(input)) > max_memory_mib * 1024u * 1024u;
+}
+
+void compression_coordinator::read_data_from_input() {
+  profiler::stage stage("read input");
+  input_data = nullptr;
+  input_size = 0;
+  if (input == "stdin") {
+    input_buffer.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    input_data = input_buffer.data();
+    input_size = input_buffer.size();
+  } else if (fs::file_size(input) > 0) {
+    // Mapped pages are backed by the file, so the input is never copied into process memory
+    mapped_input.open(input);
+    input_data = reinterpret_cast<const uint8_t*>(mapped_input.data());
+    input_size = mapped_input.size();
+  }
+}
+
+size_t compression_coordinator::read_available_input(uint8_t* data, size_t size) {
+#if __has_include(<poll.h>) && __has_include(<unistd.h>)
+  // std::cin would wait for the whole chunk, so stdin is read directly: the first read waits for any input, the
+  // following ones only as long as more keeps arriving within PARTIAL_CHUNK_DELAY_MS
+  size_t read_bytes = 0;
+  while (read_bytes < size) {
+    if (read_bytes > 0) {
+      pollfd pending_input{STDIN_FILENO, POLLIN, 0};
+      const int ready = ::poll(&pending_input, 1, PARTIAL_CHUNK_DELAY_MS);
+      if (ready == 0) break;
+      if (ready < 0) {
+        if (errno == EINTR) continue;
+        throw std::runtime_error("Error: failed to wait for input data");
       }
-      data.pop_back();
     }
+    const ssize_t result = ::read(STDIN_FILENO, data + read_bytes, size - read_bytes);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("Error: failed to read input data");
+    }
+    if (result == 0) break;
+    read_bytes += static_cast<size_t>(result);
   }
-  return data;
+  return read_bytes;
+#else
+  std::cin.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+  return static_cast<size_t>(std::cin.gcount());
+#endif
 }
 
-void compression_coordinator::output_encoded_data(const std::vector<uint8_t>& data) {
+std::ostream& compression_coordinator::output_stream() {
   if (output == "stdout") {
-    for (const auto byte : data) {
-      std::cout << byte;
-    }
-  } else {
-    std::ofstream out(output);
-    for (const auto byte : data) {
-      out << byte;
+    // stdout can't seek back to the frame header, so a framed member is held until its size is known
+    return frame ? framed_output : std::cout;
+  }
+  if (!output_file.is_open()) {
+    output_file.open(output, std::ios::binary);
+    if (frame) {
+      // Placeholder, finish_frame() fills in the member size
+      std::vector<uint8_t> header;
+      member_frame::write_header(header, 0);
+      output_file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
     }
   }
+  return output_file;
+}
+
+void compression_coordinator::finish_frame() {
+  std::vector<uint8_t> header;
+  if (output == "stdout") {
+    const std::string member = framed_output.str();
+    if (member.empty()) return;  // empty input ignored, nothing to frame
+    member_frame::write_header(header, member.size());
+    std::cout.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    std::cout.write(member.data(), static_cast<std::streamsize>(member.size()));
+    std::cout.flush();
+  } else if (output_file.is_open()) {
+    const std::streamoff end = output_file.tellp();
+    member_frame::write_header(header, static_cast<uint64_t>(end) - member_frame::FRAME_HEADER_SIZE);
+    output_file.seekp(0);
+    output_file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    output_file.seekp(end);
+    output_file.flush();
+    if (!output_file) throw std::runtime_error("Error: couldn't write the member frame");
+  }
 }
 
-void compression_coordinator::validate_options(const std::string& input_, const std::string& output_) {
-  if (input_ != "stdin" && !fs::exists(input_)) {
-    throw std::runtime_error(fmt::format("Error: input file {} doesn't exist", input_));
+void compression_coordinator::output_encoded_data(const std::vector<uint8_t>& data) {
+  profiler::stage stage("write output");
+  output_stream().write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+void compression_coordinator::validate_options(const options& options_) {
+  if (options_.input != "stdin" && !fs::exists(options_.input)) {
+    throw std::runtime_error(fmt::format("Error: input file {} doesn't exist", options_.input));
+  }
+  if (options_.output != "stdout" && fs::exists(options_.output)) {
+    throw std::runtime_error(fmt::format("Error: output file {} already exists", options_.output));
+  }
+  if (options_.adaptive_chunk_kib > adaptive_encoder::MAX_CHUNK_SIZE / 1024u) {
+    throw std::runtime_error(fmt::format("Error: adaptive chunk size can't exceed {} KiB",
+                                         adaptive_encoder::MAX_CHUNK_SIZE / 1024u));
+  }
+  if (options_.block_size_kib > block_encoder::MAX_BLOCK_SIZE / 1024u) {
+    throw std::runtime_error(
+        fmt::format("Error: block size can't exceed {} KiB", block_encoder::MAX_BLOCK_SIZE / 1024u));
+  }
+  const bool block_mode = options_.block_size_kib > 0 || options_.level;
+  if ((options_.adaptive_chunk_kib > 0) + block_mode + (options_.sync_interval_kib > 0) > 1) {
+    throw std::runtime_error(
+        "Error: only one coding mode allowed, you specified several (--adaptive, --block-size or --level, "
+        "--sync-interval)");
+  }
+  if (options_.frame && options_.output == "stdout" && options_.max_memory_mib > 0) {
+    throw std::runtime_error(
+        "Error: --frame holds the whole output in memory when writing to stdout, which --max-memory rules out");
+  }
+  if (options_.sync_interval_kib > 0 && options_.max_memory_mib > 0) {
+    throw std::runtime_error(
+        "Error: --sync-interval codes the whole input at once with a single code, which --max-memory rules out");
+  }
+  if (options_.plan_blocks && !block_mode) {
+    throw std::runtime_error("Error: --plan-blocks needs block mode (--block-size or --level)");
   }
-  if (output_ != "stdout" && fs::exists(output_)) {
-    throw std::runtime_error(fmt::format("Error: output file {} already exists", output_));
+  if (options_.code_reuse_tolerance && !block_mode) {
+    throw std::runtime_error("Error: --code-reuse-tolerance needs block mode (--block-size or --level)");
   }
 }
\ No newline at end of file
@@ -1,20 +1,98 @@
 #ifndef COMPRESSION_COORDINATOR_HPP
 #define COMPRESSION_COORDINATOR_HPP
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "../coder/block_encoder.hpp"
+#include "../coder/chunk_encoder.hpp"
+#include "compression_level.hpp"
+
 class compression_coordinator {
  public:
-  void perform_compression(const std::string& input, const std::string& output, bool ignore_empty, bool verbose);
+  /// @brief Amount of input planned and encoded at once in planned block mode.
+  static constexpr size_t PLANNING_BATCH_SIZE = 64u << 20;
+
+  /// @brief Time in milliseconds an adaptive chunk read from stdin waits for more input before the bytes received so
+  /// far are encoded, so that a slow pipe gets its output right away without coding every write as its own chunk.
+  static constexpr int PARTIAL_CHUNK_DELAY_MS = 50;
+
+  /// @brief Options of a compression run, filled in from the command line.
+  struct options {
+    /// @brief Input file name, "stdin" to read standard input.
+    std::string input = "stdin";
+    /// @brief Output file name, "stdout" to write standard output.
+    std::string output = "stdout";
+    /// @brief Whether empty input ends the run without an error.
+    bool ignore_empty = false;
+    /// @brief Whether to print the configuration and each step.
+    bool verbose = false;
+    /// @brief Chunk size of adaptive mode in KiB, 0 for another mode.
+    uint32_t adaptive_chunk_kib = 0;
+    /// @brief Block size of block mode in KiB (the maximum with planned blocks), 0 for another mode or the preset's.
+    uint32_t block_size_kib = 0;
+    /// @brief How much larger (in percent) a block may get when it reuses the previous block's code, unset for the
+    /// default or the preset's.
+    std::optional<uint32_t> code_reuse_tolerance;
+    /// @brief Memory limit in MiB, 0 for none.
+    uint64_t max_memory_mib = 0;
+    /// @brief Sync interval of stream mode in KiB, 0 for another mode.
+    uint32_t sync_interval_kib = 0;
+    /// @brief Block mode preset.
+    std::optional<compression_level::preset> level;
+    /// @brief Whether block boundaries are planned from the data.
+    bool plan_blocks = false;
+    /// @brief Maximum number of threads.
+    unsigned threads = 1;
+    /// @brief Whether the output is wrapped in a member frame.
+    bool frame = false;
+  };
+
+  void perform_compression(const options& options_);
+
+  /// @brief Estimates the peak memory of the basic (whole-input) mode: the input, memory-mapped for files or read
+  /// into memory for stdin, plus the encoded output, which is allocated at its exact size and is at most about as
+  /// large as the input.
+  /// @param input_size Input size in bytes.
+  /// @return Estimated peak memory in bytes.
+  static uint64_t estimate_peak_memory(uint64_t input_size);
 
  private:
   std::string input;
   std::string output;
   bool ignore_empty;
   bool verbose;
+  uint32_t adaptive_chunk_kib;
+  uint32_t block_size_kib;
+  uint32_t code_reuse_tolerance;
+  uint64_t max_memory_mib;
+  uint32_t sync_interval_kib;
+  std::optional<compression_level::preset> level;
+  bool plan_blocks;
+  unsigned threads;
+  bool frame;
+  boost::iostreams::mapped_file_source mapped_input;
+  std::vector<uint8_t> input_buffer;
+  const uint8_t* input_data;
+  size_t input_size;
+  std::ofstream output_file;
+  std::ostringstream framed_output;
 
-  void validate_options(const std::string& input, const std::string& output);
-  std::vector<uint8_t> read_data_from_input();
+  void validate_options(const options& options_);
+  void perform_coding(const compression_level::settings& block_settings);
+  void perform_chunked_compression(chunk_encoder& coder, size_t chunk_size, bool encode_partial_chunks);
+  void perform_planned_compression(block_encoder& coder, size_t max_block_size);
+  bool exceeds_max_memory();
+  void read_data_from_input();
+  size_t read_available_input(uint8_t* data, size_t size);
+  std::ostream& output_stream();
+  void finish_frame();
   void output_encoded_data(const std::vector<uint8_t>& data);
 };
 
@@ -0,0 +1,39 @@
+#include "compression_level.hpp"
+
+#include <fmt/core.h>
+
+#include <stdexcept>
+
+compression_level::preset compression_level::parse(const std::string& name) {
+  if (name == "fastest") return preset::fastest;
+  if (name == "balanced") return preset::balanced;
+  if (name == "best") return preset::best;
+  throw std::runtime_error(fmt::format("Error: unknown compression level {} (use fastest, balanced or best)", name));
+}
+
+const char* compression_level::get_name(preset level) {
+  switch (level) {
+    case preset::fastest:
+      return "fastest";
+    case preset::balanced:
+      return "balanced";
+    case preset::best:
+      return "best";
+  }
+  return "";
+}
+
+compression_level::settings compression_level::get_settings(preset level) {
+  switch (level) {
+    case preset::fastest:
+      // Large blocks amortize building codes, a 1/16 sample of the histogram and 11-bit codes make each build cheap
+      return {4096, 5, 11, 16, false, false};
+    case preset::balanced:
+      return {1024, 1, 15, 0, true, false};
+    case preset::best:
+      // Blocks end where the data changes, much smaller blocks than 256 KiB would make the decoder spend more time
+      // building decode tables than decoding
+      return {256, 0, 15, 0, true, true};
+  }
+  return {};
+}
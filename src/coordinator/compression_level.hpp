@@ -0,0 +1,40 @@
+#ifndef COMPRESSION_LEVEL_HPP
+#define COMPRESSION_LEVEL_HPP
+#include <cstdint>
+#include <string>
+
+/// @brief Compression level presets selected with --level. All of them produce block mode streams, so they are
+/// decoded by the same table-driven loop; levels only change how much work the encoder spends on each block.
+class compression_level {
+ public:
+  /// @brief Preset name.
+  enum class preset : uint8_t { fastest, balanced, best };
+
+  /// @brief Block encoder settings of a preset.
+  struct settings {
+    /// @brief Block size in KiB.
+    uint32_t block_size_kib;
+    /// @brief How much larger (in percent) a block may get when it reuses the previous block's code.
+    uint32_t code_reuse_tolerance;
+    /// @brief Maximum code length in bits.
+    uint8_t max_code_length;
+    /// @brief Histogram sampling interval, 0 for exact histograms (see huffman::sample_frequencies()).
+    uint32_t sampling_interval;
+    /// @brief Whether every block carries a CRC-32.
+    bool checksum;
+    /// @brief Whether block boundaries are planned from the data (then block_size_kib is the maximum block size).
+    bool plan_blocks;
+  };
+
+  /// @brief Parses a preset name. Throws std::runtime_error for unknown names.
+  /// @param name One of "fastest", "balanced" or "best".
+  static preset parse(const std::string& name);
+
+  /// @brief Returns the name of a preset.
+  static const char* get_name(preset level);
+
+  /// @brief Returns the settings of a preset.
+  static settings get_settings(preset level);
+};
+
+#endif  // COMPRESSION_LEVEL_HPP
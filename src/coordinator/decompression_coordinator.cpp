@@ -3,19 +3,29 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
+#include <algorithm>
 #include <boost/filesystem.hpp>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
 
+#include "../coder/chunk_walker.hpp"
+#include "../coder/container.hpp"
 #include "../coder/decoder.hpp"
+#include "../coder/member_decoder.hpp"
+#include "../coder/member_frame.hpp"
+#include "../coder/parallel.hpp"
+#include "../coder/stream_decoder.hpp"
+#include "../profiler/profiler.hpp"
 
 namespace fs = boost::filesystem;
 
 void decompression_coordinator::perform_decompression(const std::string& input_, const std::string& output_,
-                                                      bool ignore_empty_, bool verbose_) {
+                                                      bool ignore_empty_, bool verbose_, unsigned threads_) {
+  profiler::stage stage("decompress");
   if (verbose_) std::cout << "Validating options..." << std::endl;
   validate_options(input_, output_);
   if (verbose_) std::cout << "Validation passed!" << std::endl << std::endl;
@@ -24,6 +34,7 @@ void decompression_coordinator::perform_decompression(const std::string& input_,
   this->output = output_;
   this->ignore_empty = ignore_empty_;
   this->verbose = verbose_;
+  this->threads = threads_;
 
   if (verbose) {
     std::cout << "Your configuration:" << std::endl;
@@ -31,10 +42,48 @@ void decompression_coordinator::perform_decompression(const std::string& input_,
     std::cout << "output source: " << output << std::endl;
     std::cout << "ignore empty data: " << std::boolalpha << ignore_empty << std::endl;
     std::cout << "verbose: " << std::boolalpha << verbose << std::endl;
+    std::cout << "threads: " << threads << std::endl;
     std::cout << std::endl;
   }
 
-  std::vector<uint8_t> data = read_data_from_input();
+  std::vector<uint8_t> data(container::HEADER_SIZE);
+  input_stream().read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+  data.resize(static_cast<size_t>(input_stream().gcount()));
+  if (container::has_header(data.data(), data.size())) {
+    const container::mode coding_mode = container::read_mode(data.data());
+    if (coding_mode == container::mode::member) {
+      read_data_from_input(data);
+      if (verbose) std::cout << "Decoding a multi-member file..." << std::endl;
+      perform_multi_member_decompression(data);
+    } else if (coding_mode == container::mode::stream) {
+      read_data_from_input(data);
+      if (verbose) std::cout << "Decoding data as a single stream..." << std::endl;
+      stream_decoder decoder(threads);
+      std::vector<uint8_t> decoded_data;
+      {
+        profiler::stage decode_stage("stream_decoder::decode");
+        decoder.decode(data.data() + container::HEADER_SIZE, data.size() - container::HEADER_SIZE, decoded_data);
+      }
+      if (verbose) {
+        std::cout << fmt::format("Sync points: {}, threads used: {}", decoder.get_sync_points(),
+                                 decoder.get_used_threads())
+                  << std::endl;
+        std::cout << fmt::format("Decoded data size: {}", decoded_data.size()) << std::endl;
+      }
+      if (verbose) std::cout << "Outputing data..." << std::endl;
+      output_decoded_data(decoded_data);
+    } else {
+      if (verbose) {
+        std::cout << (coding_mode == container::mode::adaptive ? "Decoding data adaptively..."
+                                                               : "Decoding data in blocks...")
+                  << std::endl;
+      }
+      perform_chunked_decompression(coding_mode);
+    }
+    return;
+  }
+
+  read_data_from_input(data);
   if (verbose) std::cout << "Total data bytes: " << data.size() << std::endl << std::endl;
   if (data.empty()) {
     if (verbose) {
@@ -48,8 +97,12 @@ void decompression_coordinator::perform_decompression(const std::string& input_,
   }
 
   if (verbose) std::cout << "Decoding data..." << std::endl;
-  decoder decoder;
-  std::vector<uint8_t> decoded_data = decoder.decode_data(data);
+  decoder decoder(threads);
+  std::vector<uint8_t> decoded_data;
+  {
+    profiler::stage decode_stage("decoder::decode_data");
+    decoded_data = decoder.decode_data(data);
+  }
   if (verbose) {
     std::cout << fmt::format("Decoded data size: {}", decoded_data.size()) << std::endl;
     std::cout << fmt::format("Decompressed {:.2f}%",
@@ -62,39 +115,116 @@ void decompression_coordinator::perform_decompression(const std::string& input_,
   output_decoded_data(decoded_data);
 }
 
-std::vector<uint8_t> decompression_coordinator::read_data_from_input() {
-  std::vector<uint8_t> data;
-  if (input == "stdin") {
-    char c;
-    while (!std::cin.eof() && std::cin.get(c)) {
-      data.push_back(c);
+void decompression_coordinator::perform_chunked_decompression(container::mode coding_mode) {
+  std::vector<uint8_t> read_buffer;
+  chunk_walker walker([this, &read_buffer](size_t size, const uint8_t*& data) {
+    profiler::stage read_stage("read input");
+    read_buffer.resize(size);
+    input_stream().read(reinterpret_cast<char*>(read_buffer.data()), static_cast<std::streamsize>(size));
+    data = read_buffer.data();
+    return static_cast<size_t>(input_stream().gcount());
+  });
+  walker.begin(coding_mode);
+
+  std::vector<uint8_t> decoded_data;
+  uint64_t total_decoded_bytes = 0;
+  while (true) {
+    decoded_data.clear();
+    {
+      profiler::stage decode_stage("chunk_decoder::decode_chunk");
+      if (!walker.next_chunk(decoded_data)) break;
     }
-  } else {
-    std::ifstream file(input);
-    file.seekg(0, std::ios::end);
-    if (file.tellg() > 0) {
-      file.clear();
-      file.seekg(0, std::ios::beg);
-      char c;
-      while (!file.eof() && file.get(c)) {
-        data.push_back(c);
-      }
+    total_decoded_bytes += decoded_data.size();
+    output_decoded_data(decoded_data);
+    output_stream().flush();
+  }
+
+  if (verbose) {
+    const uint64_t total_encoded_bytes = walker.get_encoded_bytes();
+    if (walker.get_streams() > 1) std::cout << fmt::format("Appended streams: {}", walker.get_streams()) << std::endl;
+    std::cout << fmt::format("Decoded data size: {}", total_decoded_bytes) << std::endl;
+    std::cout << fmt::format("Decompressed {:.2f}%", 100.0 *
+                                                         (static_cast<double>(total_decoded_bytes) -
+                                                          static_cast<double>(total_encoded_bytes)) /
+                                                         static_cast<double>(total_encoded_bytes))
+              << std::endl;
+    if (walker.get_cache_hits() + walker.get_cache_misses() > 0) {
+      std::cout << fmt::format("Code cache hits: {}, misses: {}", walker.get_cache_hits(), walker.get_cache_misses())
+                << std::endl;
     }
   }
-  return data;
 }
 
-void decompression_coordinator::output_decoded_data(const std::vector<uint8_t>& data) {
-  if (output == "stdout") {
-    for (const auto byte : data) {
-      std::cout << byte;
+void decompression_coordinator::perform_multi_member_decompression(const std::vector<uint8_t>& data) {
+  std::vector<member_frame::member> members;
+  {
+    profiler::stage find_stage("member_frame::find_members");
+    members = member_frame::find_members(data.data(), data.size());
+  }
+  // Members are decoded side by side on one thread each, a lone member gets all threads for itself
+  const unsigned member_threads = members.size() == 1 ? threads : 1u;
+  const size_t batch_size = size_t{std::max(threads, 1u)} * MEMBER_BATCH_FACTOR;
+  std::vector<std::vector<uint8_t>> decoded_members(batch_size);
+  uint64_t total_decoded_bytes = 0;
+  for (size_t first = 0; first < members.size(); first += batch_size) {
+    const size_t count = std::min(batch_size, members.size() - first);
+    {
+      profiler::stage decode_stage("member_decoder::decode");
+      parallel::for_each(threads, count, [&](size_t i) {
+        const member_frame::member& member = members[first + i];
+        decoded_members[i].clear();
+        member_decoder decoder(member_threads);
+        decoder.decode(data.data() + member.offset, member.size, decoded_members[i]);
+      });
     }
-  } else {
-    std::ofstream out(output);
-    for (const auto byte : data) {
-      out << byte;
+    // Written in file order once the whole batch is decoded, so the output is the concatenation of the members
+    for (size_t i = 0; i < count; ++i) {
+      total_decoded_bytes += decoded_members[i].size();
+      output_decoded_data(decoded_members[i]);
+      std::vector<uint8_t>().swap(decoded_members[i]);
     }
+    output_stream().flush();
   }
+
+  if (verbose) {
+    std::cout << fmt::format("Members: {}", members.size()) << std::endl;
+    std::cout << fmt::format("Decoded data size: {}", total_decoded_bytes) << std::endl;
+    std::cout << fmt::format("Decompressed {:.2f}%", 100.0 *
+                                                         (static_cast<double>(total_decoded_bytes) -
+                                                          static_cast<double>(data.size())) /
+                                                         static_cast<double>(data.size()))
+              << std::endl;
+  }
+}
+
+std::istream& decompression_coordinator::input_stream() {
+  if (input == "stdin") {
+    return std::cin;
+  }
+  if (!input_file.is_open()) {
+    input_file.open(input, std::ios::binary);
+  }
+  return input_file;
+}
+
+void decompression_coordinator::read_data_from_input(std::vector<uint8_t>& data) {
+  profiler::stage stage("read input");
+  data.insert(data.end(), std::istreambuf_iterator<char>(input_stream()), std::istreambuf_iterator<char>());
+}
+
+std::ostream& decompression_coordinator::output_stream() {
+  if (output == "stdout") {
+    return std::cout;
+  }
+  if (!output_file.is_open()) {
+    output_file.open(output, std::ios::binary);
+  }
+  return output_file;
+}
+
+void decompression_coordinator::output_decoded_data(const std::vector<uint8_t>& data) {
+  profiler::stage stage("write output");
+  output_stream().write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
 }
 
 void decompression_coordinator::validate_options(const std::string& input_, const std::string& output_) {
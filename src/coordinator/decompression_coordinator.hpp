@@ -1,20 +1,38 @@
 #ifndef DECOMPRESSION_COORDINATOR_HPP
 #define DECOMPRESSION_COORDINATOR_HPP
+#include <cstddef>
+#include <fstream>
+#include <istream>
+#include <ostream>
 #include <string>
 #include <vector>
 
+#include "../coder/container.hpp"
+
 class decompression_coordinator {
  public:
-  void perform_decompression(const std::string& input, const std::string& output, bool ignore_empty, bool verbose);
+  /// @brief Members decoded at once per thread in a multi-member file, which bounds the memory held by decoded
+  /// members waiting to be written in order.
+  static constexpr size_t MEMBER_BATCH_FACTOR = 2;
+
+  void perform_decompression(const std::string& input, const std::string& output, bool ignore_empty, bool verbose,
+                             unsigned threads);
 
  private:
   std::string input;
   std::string output;
   bool ignore_empty;
   bool verbose;
+  unsigned threads;
+  std::ifstream input_file;
+  std::ofstream output_file;
 
   void validate_options(const std::string& input, const std::string& output);
-  std::vector<uint8_t> read_data_from_input();
+  void perform_chunked_decompression(container::mode coding_mode);
+  void perform_multi_member_decompression(const std::vector<uint8_t>& data);
+  std::istream& input_stream();
+  void read_data_from_input(std::vector<uint8_t>& data);
+  std::ostream& output_stream();
   void output_decoded_data(const std::vector<uint8_t>& data);
 };
 
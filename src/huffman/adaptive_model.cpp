@@ -0,0 +1,26 @@
+#include "adaptive_model.hpp"
+
+#include "huffman.hpp"
+
+adaptive_model::adaptive_model(bool with_decode_table) : m_with_decode_table(with_decode_table) {
+  // Every byte keeps a non-zero count, so that any byte can show up in the next chunk.
+  m_counts.fill(1);
+  if (m_with_decode_table) m_code.build_decode_table();
+}
+
+void adaptive_model::update(const uint8_t* data, size_t size) {
+  huffman::count_frequencies(data, size, m_counts);
+  uint64_t total = 0;
+  for (const auto count : m_counts) {
+    total += count;
+  }
+  while (total > MAX_TOTAL_COUNT) {
+    total = 0;
+    for (auto& count : m_counts) {
+      count = (count + 1) / 2;
+      total += count;
+    }
+  }
+  m_code = canonical_code(huffman::calculate_code_lengths(m_counts, canonical_code::MAX_CODE_LENGTH));
+  if (m_with_decode_table) m_code.build_decode_table();
+}
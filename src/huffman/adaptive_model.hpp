@@ -0,0 +1,34 @@
+#ifndef ADAPTIVE_MODEL_HPP
+#define ADAPTIVE_MODEL_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "canonical_code.hpp"
+
+/// @brief Byte statistics that the adaptive encoder and decoder keep in lockstep. Both start from a code where each
+/// byte is 8 bits long and rebuild the code from the running counts after every chunk, so no codebook is ever stored.
+class adaptive_model {
+ public:
+  /// @brief Once the counts sum up to this value they are halved, so that the model follows changes in the data.
+  static constexpr uint64_t MAX_TOTAL_COUNT = uint64_t{1} << 24;
+
+  /// @brief Constructs the initial model.
+  /// @param with_decode_table Whether the decode table has to be maintained (decoders only).
+  explicit adaptive_model(bool with_decode_table);
+
+  /// @brief Accounts for a coded chunk and rebuilds the code.
+  /// @param data Pointer to the first byte of the chunk.
+  /// @param size Number of bytes in the chunk.
+  void update(const uint8_t* data, size_t size);
+
+  /// @brief Returns the code to be used for the next chunk.
+  const canonical_code& get_code() const { return m_code; }
+
+ private:
+  bool m_with_decode_table;
+  std::array<uint64_t, 256> m_counts;
+  canonical_code m_code;
+};
+
+#endif  // ADAPTIVE_MODEL_HPP
@@ -0,0 +1,95 @@
+#include "canonical_code.hpp"
+
+#include <fmt/core.h>
+
+#include <stdexcept>
+
+namespace {
+
+std::array<uint8_t, 256> uniform_lengths() {
+  std::array<uint8_t, 256> lengths;
+  lengths.fill(8);
+  return lengths;
+}
+
+uint16_t reverse_bits(uint16_t code, uint8_t length) {
+  uint16_t reversed = 0;
+  for (uint8_t i = 0; i < length; ++i) {
+    reversed = static_cast<uint16_t>((reversed << 1) | ((code >> i) & 1u));
+  }
+  return reversed;
+}
+
+}  // namespace
+
+canonical_code::canonical_code() : canonical_code(uniform_lengths()) {}
+
+canonical_code::canonical_code(const std::array<uint8_t, 256>& lengths)
+    : m_lengths(lengths), m_codes{}, m_max_length(0), m_complete(false) {
+  std::array<uint16_t, MAX_CODE_LENGTH + 1> length_counts{};
+  for (const auto length : m_lengths) {
+    if (length > MAX_CODE_LENGTH) {
+      throw std::runtime_error(fmt::format("Error: code length {} exceeds the maximum of {}", length, MAX_CODE_LENGTH));
+    }
+    ++length_counts[length];
+    m_max_length = std::max(m_max_length, length);
+  }
+
+  // Kraft inequality in fixed point: every code of length l occupies 2^(MAX_CODE_LENGTH - l) slots.
+  uint32_t used_slots = 0;
+  for (uint8_t length = 1; length <= MAX_CODE_LENGTH; ++length) {
+    used_slots += uint32_t{length_counts[length]} << (MAX_CODE_LENGTH - length);
+  }
+  if (used_slots > (1u << MAX_CODE_LENGTH)) {
+    throw std::runtime_error("Error: code lengths are over-subscribed (Kraft inequality violated)");
+  }
+  m_complete = used_slots == (1u << MAX_CODE_LENGTH);
+
+  std::array<uint16_t, MAX_CODE_LENGTH + 2> next_code{};
+  for (uint8_t length = 1; length <= MAX_CODE_LENGTH; ++length) {
+    next_code[length + 1] = static_cast<uint16_t>((next_code[length] + length_counts[length]) << 1);
+  }
+  for (size_t byte = 0; byte < 256; ++byte) {
+    const uint8_t length = m_lengths[byte];
+    if (length > 0) {
+      m_codes[byte] = reverse_bits(next_code[length]++, length);
+    }
+  }
+}
+
+std::array<uint8_t, 256> canonical_code::read_lengths(const uint8_t* data) {
+  std::array<uint8_t, 256> lengths;
+  for (size_t i = 0; i < PACKED_LENGTHS_SIZE; ++i) {
+    lengths[2 * i] = data[i] & 0xFu;
+    lengths[2 * i + 1] = static_cast<uint8_t>(data[i] >> 4);
+  }
+  return lengths;
+}
+
+void canonical_code::write_lengths(std::vector<uint8_t>& out) const {
+  for (size_t i = 0; i < PACKED_LENGTHS_SIZE; ++i) {
+    out.push_back(static_cast<uint8_t>(m_lengths[2 * i] | (m_lengths[2 * i + 1] << 4)));
+  }
+}
+
+uint64_t canonical_code::calculate_encoded_bits(const std::array<uint64_t, 256>& frequencies) const {
+  uint64_t bits = 0;
+  for (size_t byte = 0; byte < 256; ++byte) {
+    if (frequencies[byte] == 0) continue;
+    if (m_lengths[byte] == 0) return UINT64_MAX;
+    bits += frequencies[byte] * m_lengths[byte];
+  }
+  return bits;
+}
+
+void canonical_code::build_decode_table() {
+  m_decode_table.assign(size_t{1} << m_max_length, 0);
+  for (size_t byte = 0; byte < 256; ++byte) {
+    const uint8_t length = m_lengths[byte];
+    if (length == 0) continue;
+    const auto entry = static_cast<uint16_t>((byte << 4) | length);
+    for (size_t index = m_codes[byte]; index < m_decode_table.size(); index += size_t{1} << length) {
+      m_decode_table[index] = entry;
+    }
+  }
+}
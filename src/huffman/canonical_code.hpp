@@ -0,0 +1,72 @@
+#ifndef CANONICAL_CODE_HPP
+#define CANONICAL_CODE_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Canonical prefix code for an alphabet of 256 bytes, fully determined by the code lengths. Codes are stored
+/// bit-reversed so that they can be written to and read from a least-significant-bit-first stream directly.
+class canonical_code {
+ public:
+  /// @brief Maximum code length supported by the table-driven coders.
+  static constexpr uint8_t MAX_CODE_LENGTH = 15;
+
+  /// @brief Size of the lengths packed by write_lengths(): two 4-bit lengths per byte.
+  static constexpr size_t PACKED_LENGTHS_SIZE = 128;
+
+  /// @brief Constructs a code where each byte has an 8-bit code (equivalent to storing bytes as is).
+  canonical_code();
+
+  /// @brief Assigns canonical codes to the given lengths. Throws std::runtime_error if a length exceeds
+  /// MAX_CODE_LENGTH or if the lengths violate the Kraft inequality (there are not enough codes for them).
+  /// @param lengths Code length of each byte value, 0 if the byte has no code.
+  explicit canonical_code(const std::array<uint8_t, 256>& lengths);
+
+  /// @brief Reads lengths packed by write_lengths().
+  /// @param data Pointer to PACKED_LENGTHS_SIZE bytes.
+  /// @return Code length of each byte value.
+  static std::array<uint8_t, 256> read_lengths(const uint8_t* data);
+
+  /// @brief Appends the code lengths packed into PACKED_LENGTHS_SIZE bytes, that's all a decoder needs to rebuild
+  /// the code.
+  void write_lengths(std::vector<uint8_t>& out) const;
+
+  /// @brief Calculates the size of the data with the given byte frequencies encoded with this code.
+  /// @param frequencies Frequency table indexed by byte value.
+  /// @return Size in bits, or UINT64_MAX if a byte that occurs in the data has no code.
+  uint64_t calculate_encoded_bits(const std::array<uint64_t, 256>& frequencies) const;
+
+  /// @brief Builds the lookup table used by decoders. Entries that don't correspond to any code are zero.
+  void build_decode_table();
+
+  /// @brief Returns the code length of each byte value.
+  /// @return Code lengths, 0 for bytes without a code.
+  const std::array<uint8_t, 256>& get_lengths() const { return m_lengths; }
+
+  /// @brief Returns the bit-reversed code of each byte value.
+  /// @return Codes, meaningful only for bytes with non-zero length.
+  const std::array<uint16_t, 256>& get_codes() const { return m_codes; }
+
+  /// @brief Tells whether the code uses up the whole code space (Kraft sum equals 1), then every decode table entry
+  /// is valid.
+  bool is_complete() const { return m_complete; }
+
+  /// @brief Returns the longest code length.
+  /// @return Longest code length in bits, 0 for an empty code.
+  uint8_t get_max_length() const { return m_max_length; }
+
+  /// @brief Returns the decode table indexed by the next get_max_length() bits of the stream. Each entry holds
+  /// (byte << 4) | length. Empty until build_decode_table() is called.
+  /// @return Decode table.
+  const std::vector<uint16_t>& get_decode_table() const { return m_decode_table; }
+
+ private:
+  std::array<uint8_t, 256> m_lengths;
+  std::array<uint16_t, 256> m_codes;
+  uint8_t m_max_length;
+  bool m_complete;
+  std::vector<uint16_t> m_decode_table;
+};
+
+#endif  // CANONICAL_CODE_HPP
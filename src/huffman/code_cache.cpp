@@ -0,0 +1,39 @@
+#include "code_cache.hpp"
+
+code_cache::code_cache(size_t capacity, bool with_decode_tables)
+    : m_capacity(capacity), m_with_decode_tables(with_decode_tables), m_hits(0), m_misses(0) {}
+
+std::shared_ptr<const canonical_code> code_cache::get(const std::array<uint8_t, 256>& lengths) {
+  const uint64_t key = fingerprint(lengths);
+  const auto found = m_index.find(key);
+  if (found != m_index.end()) {
+    // The fingerprint only narrows the search down, a colliding entry is rebuilt in place.
+    if (found->second->second->get_lengths() == lengths) {
+      ++m_hits;
+      m_entries.splice(m_entries.begin(), m_entries, found->second);
+      return found->second->second;
+    }
+    m_entries.erase(found->second);
+    m_index.erase(found);
+  }
+
+  ++m_misses;
+  auto code = std::make_shared<canonical_code>(lengths);
+  if (m_with_decode_tables) code->build_decode_table();
+  m_entries.emplace_front(key, code);
+  m_index[key] = m_entries.begin();
+  if (m_entries.size() > m_capacity) {
+    m_index.erase(m_entries.back().first);
+    m_entries.pop_back();
+  }
+  return code;
+}
+
+uint64_t code_cache::fingerprint(const std::array<uint8_t, 256>& lengths) {
+  uint64_t hash = 14695981039346656037ull;
+  for (const auto length : lengths) {
+    hash ^= length;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
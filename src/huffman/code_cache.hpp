@@ -0,0 +1,50 @@
+#ifndef CODE_CACHE_HPP
+#define CODE_CACHE_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "canonical_code.hpp"
+
+/// @brief LRU cache of built canonical codes (and their decode tables) keyed by a fingerprint of the code lengths.
+/// Blocks with similar byte distributions usually end up with the same lengths, so their codes are built only once.
+class code_cache {
+ public:
+  /// @brief Number of codes kept by default.
+  static constexpr size_t DEFAULT_CAPACITY = 32;
+
+  /// @brief Constructs an empty cache.
+  /// @param capacity Maximum number of cached codes.
+  /// @param with_decode_tables Whether cached codes get decode tables built (decoders only).
+  code_cache(size_t capacity, bool with_decode_tables);
+
+  /// @brief Returns the code for the given lengths, building it on a miss. Throws std::runtime_error if the lengths
+  /// don't form a valid code.
+  /// @param lengths Code length of each byte value.
+  /// @return Shared code, stays valid after eviction.
+  std::shared_ptr<const canonical_code> get(const std::array<uint8_t, 256>& lengths);
+
+  /// @brief Returns the number of lookups that found a ready code.
+  uint64_t get_hits() const { return m_hits; }
+
+  /// @brief Returns the number of lookups that had to build a code.
+  uint64_t get_misses() const { return m_misses; }
+
+  /// @brief Calculates the FNV-1a hash of the code lengths.
+  static uint64_t fingerprint(const std::array<uint8_t, 256>& lengths);
+
+ private:
+  using entry = std::pair<uint64_t, std::shared_ptr<const canonical_code>>;
+
+  size_t m_capacity;
+  bool m_with_decode_tables;
+  std::list<entry> m_entries;  // most recently used first
+  std::unordered_map<uint64_t, std::list<entry>::iterator> m_index;
+  uint64_t m_hits;
+  uint64_t m_misses;
+};
+
+#endif  // CODE_CACHE_HPP
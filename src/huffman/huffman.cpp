@@ -3,12 +3,13 @@
 #include <fmt/core.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <queue>
 #include <stack>
 #include <stdexcept>
 
-huffman::huffman() : m_state(state::uninitialized) {}
+huffman::huffman() : m_state(state::uninitialized), m_data_view(nullptr), m_data_size(0) {}
 
 std::shared_ptr<huffman::node> huffman::build_tree_from_codebook(
     std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>> codebook) {
@@ -36,22 +37,151 @@ std::shared_ptr<huffman::node> huffman::build_tree_from_codebook(
   return root;
 }
 
+void huffman::count_frequencies(const uint8_t* data, size_t size, std::array<uint64_t, 256>& frequencies) {
+  // Four interleaved tables break the store-to-load dependency on runs of the same byte.
+  std::array<std::array<uint32_t, 256>, 4> partial{};
+  while (size > 0) {
+    const size_t batch = std::min<size_t>(size, UINT32_MAX);
+    size_t i = 0;
+    for (; i + 4 <= batch; i += 4) {
+      ++partial[0][data[i]];
+      ++partial[1][data[i + 1]];
+      ++partial[2][data[i + 2]];
+      ++partial[3][data[i + 3]];
+    }
+    for (; i < batch; ++i) {
+      ++partial[0][data[i]];
+    }
+    for (size_t byte = 0; byte < 256; ++byte) {
+      frequencies[byte] += uint64_t{partial[0][byte]} + partial[1][byte] + partial[2][byte] + partial[3][byte];
+      partial[0][byte] = partial[1][byte] = partial[2][byte] = partial[3][byte] = 0;
+    }
+    data += batch;
+    size -= batch;
+  }
+}
+
+void huffman::sample_frequencies(const uint8_t* data, size_t size, uint32_t sampling_interval,
+                                 std::array<uint64_t, 256>& frequencies) {
+  const uint32_t interval = std::max<uint32_t>(sampling_interval, 1u);
+  // Same interleaving as count_frequencies(), with the tables merged once at the end rather than once per run.
+  std::array<std::array<uint64_t, 256>, 4> partial{};
+  for (size_t offset = 0; offset < size; offset += SAMPLE_RUN_SIZE * interval) {
+    const uint8_t* run = data + offset;
+    const size_t run_size = std::min(SAMPLE_RUN_SIZE, size - offset);
+    size_t i = 0;
+    for (; i + 4 <= run_size; i += 4) {
+      ++partial[0][run[i]];
+      ++partial[1][run[i + 1]];
+      ++partial[2][run[i + 2]];
+      ++partial[3][run[i + 3]];
+    }
+    for (; i < run_size; ++i) {
+      ++partial[0][run[i]];
+    }
+  }
+  for (size_t byte = 0; byte < 256; ++byte) {
+    frequencies[byte] = (partial[0][byte] + partial[1][byte] + partial[2][byte] + partial[3][byte]) * interval + 1u;
+  }
+}
+
+std::array<uint8_t, 256> huffman::calculate_code_lengths(const std::array<uint64_t, 256>& frequencies,
+                                                         uint8_t max_length) {
+  if (max_length < 8) {
+    throw std::logic_error(fmt::format("Error: maximum code length {} can't fit 256 codes", max_length));
+  }
+  std::array<uint8_t, 256> lengths{};
+  std::array<uint64_t, 256> scaled = frequencies;
+  while (true) {
+    std::array<uint8_t, 256> symbols;
+    size_t total = 0;
+    for (size_t byte = 0; byte < 256; ++byte) {
+      if (scaled[byte] > 0) symbols[total++] = static_cast<uint8_t>(byte);
+    }
+    if (total == 0) {
+      return lengths;
+    }
+    if (total == 1) {
+      lengths[symbols[0]] = 1;
+      return lengths;
+    }
+    std::sort(symbols.begin(), symbols.begin() + static_cast<std::ptrdiff_t>(total), [&scaled](uint8_t a, uint8_t b) {
+      return scaled[a] != scaled[b] ? scaled[a] < scaled[b] : a < b;
+    });
+
+    // Two-queue construction: leaves come sorted, internal nodes are produced in non-decreasing weight order, so the
+    // two smallest nodes are always at the queue heads. Internal nodes are numbered after their children.
+    std::array<uint64_t, 511> weight;
+    std::array<uint16_t, 511> parent;
+    for (size_t i = 0; i < total; ++i) {
+      weight[i] = scaled[symbols[i]];
+    }
+    size_t next_leaf = 0;
+    size_t next_internal = total;
+    size_t end_internal = total;
+    auto pop_smallest = [&]() -> size_t {
+      if (next_leaf < total && (next_internal == end_internal || weight[next_leaf] <= weight[next_internal])) {
+        return next_leaf++;
+      }
+      return next_internal++;
+    };
+    for (size_t merges = 0; merges + 1 < total; ++merges) {
+      const size_t first = pop_smallest();
+      const size_t second = pop_smallest();
+      weight[end_internal] = weight[first] + weight[second];
+      parent[first] = parent[second] = static_cast<uint16_t>(end_internal);
+      ++end_internal;
+    }
+
+    std::array<uint8_t, 511> depth;
+    const size_t root = end_internal - 1;
+    depth[root] = 0;
+    uint8_t longest = 0;
+    for (size_t i = root; i-- > 0;) {
+      depth[i] = static_cast<uint8_t>(depth[parent[i]] + 1);
+      if (i < total) longest = std::max(longest, depth[i]);
+    }
+    if (longest <= max_length) {
+      for (size_t i = 0; i < total; ++i) {
+        lengths[symbols[i]] = depth[i];
+      }
+      return lengths;
+    }
+    for (auto& frequency : scaled) {
+      frequency = (frequency + 1) / 2;
+    }
+  }
+}
+
 void huffman::initialize_data(const std::vector<uint8_t>& data) {
   validate_desired_state(state::initialized);
   this->m_data = data;
+  m_data_view = m_data.data();
+  m_data_size = m_data.size();
   m_state = state::initialized;
 }
 
 void huffman::initialize_data(std::vector<uint8_t>&& data) {
   validate_desired_state(state::initialized);
   this->m_data = std::move(data);
+  m_data_view = m_data.data();
+  m_data_size = m_data.size();
+  m_state = state::initialized;
+}
+
+void huffman::initialize_data(const uint8_t* data, size_t size) {
+  validate_desired_state(state::initialized);
+  m_data_view = data;
+  m_data_size = size;
   m_state = state::initialized;
 }
 
 void huffman::calculate_frequencies() {
   validate_desired_state(state::unsorted_frequencies);
-  for (const auto byte : m_data) {
-    ++m_frequencies[byte];
+  std::array<uint64_t, 256> frequencies{};
+  count_frequencies(m_data_view, m_data_size, frequencies);
+  for (size_t byte = 0; byte < 256; ++byte) {
+    if (frequencies[byte] > 0) m_frequencies[static_cast<uint8_t>(byte)] = frequencies[byte];
   }
   m_state = state::unsorted_frequencies;
 }
@@ -126,6 +256,8 @@ void huffman::clear_state() {
   m_root = nullptr;
   m_data.clear();
   m_data.shrink_to_fit();
+  m_data_view = nullptr;
+  m_data_size = 0;
   m_frequencies.clear();
   m_sorted_frequencies.clear();
   m_sorted_frequencies.shrink_to_fit();
@@ -144,10 +276,12 @@ void huffman::validate_desired_state(state next_state) {
   }
 }
 
-std::vector<uint8_t> huffman::get_data() { return m_data; }
+std::vector<uint8_t> huffman::get_data() { return std::vector<uint8_t>(m_data_view, m_data_view + m_data_size); }
 
-std::map<uint8_t, uint64_t> huffman::get_frequencies() { return m_frequencies; }
+const std::map<uint8_t, uint64_t>& huffman::get_frequencies() const { return m_frequencies; }
 
-std::vector<std::pair<uint8_t, uint64_t>> huffman::get_sorted_frequencies() { return m_sorted_frequencies; }
+const std::vector<std::pair<uint8_t, uint64_t>>& huffman::get_sorted_frequencies() const {
+  return m_sorted_frequencies;
+}
 
-std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>> huffman::get_codebook() { return m_codebook; }
+const std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>>& huffman::get_codebook() const { return m_codebook; }
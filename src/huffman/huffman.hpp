@@ -1,6 +1,8 @@
 #ifndef HUFFMAN_HPP
 #define HUFFMAN_HPP
+#include <array>
 #include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -33,6 +35,11 @@ class huffman {
   /// @param data A move-only vector of bytes to be compressed.
   void initialize_data(std::vector<uint8_t>&& data);
 
+  /// @brief Initializes the Huffman instance with borrowed data (e.g. a memory-mapped file) without copying it.
+  /// @param data Pointer to the first byte, must stay valid until clear_state() or destruction.
+  /// @param size Number of bytes.
+  void initialize_data(const uint8_t* data, size_t size);
+
   /// @brief Calculates the frequency of each byte in the input data.
   void calculate_frequencies();
 
@@ -55,12 +62,12 @@ class huffman {
 
   /// @brief Returns a map that contains the frequency of each byte in the input data.
   /// @return A map that contains the frequency of each byte in the input data.
-  std::map<uint8_t, uint64_t> get_frequencies();
+  const std::map<uint8_t, uint64_t>& get_frequencies() const;
 
   /// @brief Returns a vector of pairs, where each pair contains a byte and its frequency in the input data.
   /// The vector is sorted in ascending order of frequency.
   /// @return A vector of pairs, sorted in ascending order of frequency.
-  std::vector<std::pair<uint8_t, uint64_t>> get_sorted_frequencies();
+  const std::vector<std::pair<uint8_t, uint64_t>>& get_sorted_frequencies() const;
 
   /// @brief Returns a map that represents the codebook generated by the Huffman coding algorithm
   /// for the current set of input data. The keys of the map are the original bytes in the input data,
@@ -68,7 +75,7 @@ class huffman {
   /// code is the binary representation of the corresponding code, stored in little-endian order
   /// (i.e., starting from the least significant bit).
   /// @return A map that represents the codebook.
-  std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>> get_codebook();
+  const std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>>& get_codebook() const;
 
   /// @brief Clears the internal state. After that it's safe to initialize new data and perform Huffman algorithm
   /// pipeline.
@@ -77,6 +84,33 @@ class huffman {
   static std::shared_ptr<node> build_tree_from_codebook(
       std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>> codebook);
 
+  /// @brief Adds the number of occurrences of each byte in the given range to the frequency table.
+  /// @param data Pointer to the first byte.
+  /// @param size Number of bytes.
+  /// @param frequencies Frequency table indexed by byte value.
+  static void count_frequencies(const uint8_t* data, size_t size, std::array<uint64_t, 256>& frequencies);
+
+  /// @brief Number of consecutive bytes counted by sample_frequencies() at each sampled position.
+  static constexpr size_t SAMPLE_RUN_SIZE = 1024;
+
+  /// @brief Estimates the frequency table from one run of SAMPLE_RUN_SIZE bytes out of every sampling_interval runs,
+  /// scaled to the full size. Every byte value gets a frequency of at least 1, so that bytes the sample missed still
+  /// get a code.
+  /// @param data Pointer to the first byte.
+  /// @param size Number of bytes.
+  /// @param sampling_interval Number of runs per sampled run, 1 counts every byte (and still gives every byte a code).
+  /// @param frequencies Frequency table indexed by byte value, overwritten.
+  static void sample_frequencies(const uint8_t* data, size_t size, uint32_t sampling_interval,
+                                 std::array<uint64_t, 256>& frequencies);
+
+  /// @brief Computes Huffman code lengths straight from a frequency table without materializing the tree. If the
+  /// longest code exceeds max_length, frequencies are halved (but kept non-zero) and the lengths are recomputed.
+  /// @param frequencies Frequency table indexed by byte value, bytes with zero frequency get no code.
+  /// @param max_length Maximum allowed code length in bits, at least 8 so that all 256 bytes always fit.
+  /// @return Code length for each byte value, 0 for bytes without a code. A lone byte gets a 1-bit code.
+  static std::array<uint8_t, 256> calculate_code_lengths(const std::array<uint64_t, 256>& frequencies,
+                                                         uint8_t max_length);
+
  private:
   enum class state {
     uninitialized,
@@ -97,7 +131,9 @@ class huffman {
 
   state m_state;
   std::shared_ptr<node> m_root;
-  std::vector<uint8_t> m_data;
+  std::vector<uint8_t> m_data;  // owned input, empty when the input is borrowed
+  const uint8_t* m_data_view;   // the input, either m_data or borrowed
+  size_t m_data_size;
   std::map<uint8_t, uint64_t> m_frequencies;
   std::vector<std::pair<uint8_t, uint64_t>> m_sorted_frequencies;
   std::map<uint8_t, std::pair<uint8_t, std::bitset<255>>> m_codebook;
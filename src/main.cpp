@@ -1,17 +1,30 @@
 #include <fmt/core.h>
 
+#include <algorithm>
+#include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <thread>
 
+#include "coder/block_encoder.hpp"
 #include "coordinator/compression_coordinator.hpp"
+#include "coordinator/compression_level.hpp"
 #include "coordinator/decompression_coordinator.hpp"
+#include "profiler/profiler.hpp"
 
 namespace po = boost::program_options;
+namespace fs = boost::filesystem;
 
 std::string compile_help_message_header();
 std::string compile_version_message();
-void compress(const std::string& input, const std::string& output, bool ignore_empty, bool verbose);
-void decompress(const std::string& input, const std::string& output, bool ignore_empty, bool verbose);
+void compress(const compression_coordinator::options& options);
+unsigned get_threads(const po::variables_map& vm);
+void decompress(const std::string& input, const std::string& output, bool ignore_empty, bool verbose,
+                unsigned threads);
+std::optional<std::string> start_profiling(const po::variables_map& vm);
+void write_profile(const std::string& trace);
 po::options_description compile_options();
 
 int main(int argc, char* argv[]) {
@@ -39,27 +52,60 @@ int main(int argc, char* argv[]) {
               << std::endl;
     std::cout << "Use --help to print a help message with the list of available options" << std::endl;
   } else if (vm.count("compress")) {
+    std::optional<std::string> trace;
     try {
-      std::string input = vm["input"].as<std::string>();
-      std::string output = vm["output"].as<std::string>();
-      bool ignore_empty = vm.count("ignore-empty");
-      bool verbose = vm.count("verbose");
-      compress(input, output, ignore_empty, verbose);
+      compression_coordinator::options options;
+      options.input = vm["input"].as<std::string>();
+      options.output = vm["output"].as<std::string>();
+      options.ignore_empty = vm.count("ignore-empty");
+      options.verbose = vm.count("verbose");
+      options.adaptive_chunk_kib = vm.count("adaptive") ? vm["adaptive"].as<uint32_t>() : 0;
+      if (vm.count("adaptive") && options.adaptive_chunk_kib == 0) {
+        throw std::runtime_error("Error: adaptive chunk size must be positive");
+      }
+      options.block_size_kib = vm.count("block-size") ? vm["block-size"].as<uint32_t>() : 0;
+      if (vm.count("block-size") && options.block_size_kib == 0) {
+        throw std::runtime_error("Error: block size must be positive");
+      }
+      // Left unset unless given, so that it overrides a --level preset only when the user asked for it
+      if (!vm["code-reuse-tolerance"].defaulted()) {
+        options.code_reuse_tolerance = vm["code-reuse-tolerance"].as<uint32_t>();
+      }
+      options.max_memory_mib = vm.count("max-memory") ? vm["max-memory"].as<uint64_t>() : 0;
+      if (vm.count("max-memory") && options.max_memory_mib == 0) {
+        throw std::runtime_error("Error: memory limit must be positive");
+      }
+      options.sync_interval_kib = vm.count("sync-interval") ? vm["sync-interval"].as<uint32_t>() : 0;
+      if (vm.count("sync-interval") && options.sync_interval_kib == 0) {
+        throw std::runtime_error("Error: sync interval must be positive");
+      }
+      if (vm.count("level")) options.level = compression_level::parse(vm["level"].as<std::string>());
+      options.plan_blocks = vm.count("plan-blocks");
+      options.frame = vm.count("frame");
+      options.threads = get_threads(vm);
+      trace = start_profiling(vm);
+      compress(options);
     } catch (const std::runtime_error& e) {
       std::cout << e.what() << std::endl;
       std::cout << "Use --help to print a help message with the list of available options" << std::endl;
     }
+    // Failed runs too, they are the ones most worth a look
+    if (trace) write_profile(*trace);
   } else if (vm.count("decompress")) {
+    std::optional<std::string> trace;
     try {
       std::string input = vm["input"].as<std::string>();
       std::string output = vm["output"].as<std::string>();
       bool ignore_empty = vm.count("ignore-empty");
       bool verbose = vm.count("verbose");
-      decompress(input, output, ignore_empty, verbose);
+      unsigned threads = get_threads(vm);
+      trace = start_profiling(vm);
+      decompress(input, output, ignore_empty, verbose, threads);
     } catch (const std::runtime_error& e) {
       std::cout << e.what() << std::endl;
       std::cout << "Use --help to print a help message with the list of available options" << std::endl;
     }
+    if (trace) write_profile(*trace);
   }
   return 0;
 }
@@ -94,8 +140,44 @@ po::options_description compile_options() {
     tw("ignore-empty", "return 0 if input content is empty (don't do anything)");
     tw("verbose,v",
        "print detailed information about the Huffman coding process, including the frequency table and codebook");
+    tw("threads", po::value<unsigned>()->value_name("<count>"),
+       "maximum number of threads for encoding planned blocks and for decoding single-stream data and "
+       "multi-member files (the number of CPU cores if not specified)");
+    tw("profile", po::value<std::string>()->value_name("<filename>"),
+       "record the time and heap allocations of every stage (reading, building the code, coding, writing) and write "
+       "them to the given file as a Chrome trace (open it in chrome://tracing or ui.perfetto.dev)");
     all_options.add(tweaks_options);
   }
+  {
+    po::options_description coding_options("Coding options (compression only)", 100);
+    auto co = coding_options.add_options();
+    co("level", po::value<std::string>()->value_name("<fastest|balanced|best>"),
+       "block mode preset trading ratio for speed: fastest uses large blocks, sampled histograms, codes of at most "
+       "11 bits and no checksums; balanced uses 1 MiB blocks; best plans blocks of up to 256 KiB that reuse the "
+       "previous code only if it isn't worse; balanced and best store a checksum of every block");
+    co("adaptive", po::value<uint32_t>()->value_name("<KiB>")->implicit_value(64),
+       "single-pass adaptive coding: output starts right away and the code is rebuilt from running byte counts "
+       "after every chunk of the given size (64 KiB if not specified), or sooner when stdin pauses");
+    co("block-size", po::value<uint32_t>()->value_name("<KiB>"),
+       "code the input in blocks of the given size, each block gets its own code or reuses the previous one");
+    co("code-reuse-tolerance",
+       po::value<uint32_t>()->value_name("<percent>")->default_value(block_encoder::DEFAULT_REUSE_TOLERANCE_PERCENT),
+       "in block mode, reuse the previous block's code if that makes the block at most this much larger "
+       "(overrides the --level preset when given)");
+    co("max-memory", po::value<uint64_t>()->value_name("<MiB>"),
+       "switch to block mode if coding the whole input at once would take more memory than that (always for stdin)");
+    co("plan-blocks",
+       "in block mode, end blocks where the byte statistics of the input change rather than every --block-size "
+       "bytes, which becomes the maximum block size (the whole input is mapped or read into memory unless "
+       "--max-memory is given, blocks are encoded in parallel)");
+    co("frame",
+       "wrap the output in a length-prefixed member frame, so that outputs appended to one another form a "
+       "multi-member file that decompresses to the concatenation of their inputs, with members decoded in parallel");
+    co("sync-interval", po::value<uint32_t>()->value_name("<KiB>"),
+       "code the input as a single stream and record a sync point every so many KiB of output, which lets the "
+       "stream be decoded by several threads (the whole input is mapped or read into memory)");
+    all_options.add(coding_options);
+  }
   return all_options;
 }
 
@@ -109,19 +191,56 @@ std::string compile_help_message_header() {
       "\techo \"Hello file!\" | ./huffman -c -o compressed_file && ./huffman -d -i compressed_file\n"
       "\t./huffman -c -i input_file | ./huffman -d\n"
       "\t./huffman -c -i input_file -o compressed_file && ./huffman -d -i compressed_file\n"
-      "\t./huffman -c -i input_file -o compressed_file && ./huffman -d -i compressed_file -o decompressed_file\n";
+      "\t./huffman -c -i input_file -o compressed_file && ./huffman -d -i compressed_file -o decompressed_file\n"
+      "\ttail -f log_file | ./huffman -c --adaptive=16 | ./huffman -d\n"
+      "\t./huffman -c --block-size 256 -i input_file -o compressed_file && ./huffman -d -i compressed_file\n"
+      "\t./huffman -c --level best -i input_file -o compressed_file && ./huffman -d -i compressed_file\n"
+      "\t./huffman -c --sync-interval 1024 -i input_file -o compressed_file && ./huffman -d --threads 4 -i "
+      "compressed_file\n";
   std::string compilation = "Description:\n" + brief_description + "\n\nUsage examples:\n" + usage_examples;
   return compilation;
 }
 
 std::string compile_version_message() { return "huffman version 0.1.0"; }
 
-void compress(const std::string& input, const std::string& output, bool ignore_empty, bool verbose) {
+void compress(const compression_coordinator::options& options) {
   compression_coordinator coordinator;
-  coordinator.perform_compression(input, output, ignore_empty, verbose);
+  coordinator.perform_compression(options);
 }
 
-void decompress(const std::string& input, const std::string& output, bool ignore_empty, bool verbose) {
+unsigned get_threads(const po::variables_map& vm) {
+  if (!vm.count("threads")) {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  unsigned threads = vm["threads"].as<unsigned>();
+  if (threads == 0) {
+    throw std::runtime_error("Error: number of threads must be positive");
+  }
+  return threads;
+}
+
+void decompress(const std::string& input, const std::string& output, bool ignore_empty, bool verbose,
+                unsigned threads) {
   decompression_coordinator coordinator;
-  coordinator.perform_decompression(input, output, ignore_empty, verbose);
+  coordinator.perform_decompression(input, output, ignore_empty, verbose, threads);
+}
+
+std::optional<std::string> start_profiling(const po::variables_map& vm) {
+  if (!vm.count("profile")) {
+    return std::nullopt;
+  }
+  std::string trace = vm["profile"].as<std::string>();
+  if (fs::exists(trace)) {
+    throw std::runtime_error(fmt::format("Error: profile file {} already exists", trace));
+  }
+  profiler::enable();
+  return trace;
+}
+
+void write_profile(const std::string& trace) {
+  std::ofstream trace_file(trace);
+  profiler::write_trace(trace_file);
+  if (!trace_file) {
+    std::cout << fmt::format("Error: couldn't write profile file {}", trace) << std::endl;
+  }
 }
@@ -0,0 +1,31 @@
+#include "allocation_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<bool> allocation_counter::m_enabled{false};
+std::atomic<uint64_t> allocation_counter::m_allocations{0};
+std::atomic<uint64_t> allocation_counter::m_allocated_bytes{0};
+
+void allocation_counter::enable() { m_enabled.store(true, std::memory_order_relaxed); }
+
+allocation_counter::totals allocation_counter::get_totals() {
+  return {m_allocations.load(std::memory_order_relaxed), m_allocated_bytes.load(std::memory_order_relaxed)};
+}
+
+// The array and nothrow forms of the standard library forward to these two, so every container and shared_ptr
+// allocation goes through record().
+void* operator new(std::size_t size) {
+  allocation_counter::record(size);
+  if (size == 0) size = 1;
+  while (true) {
+    if (void* pointer = std::malloc(size)) return pointer;
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) throw std::bad_alloc();
+    handler();
+  }
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
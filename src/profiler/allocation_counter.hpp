@@ -0,0 +1,38 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Counts heap allocations made through the global operator new, which this program replaces, so that the
+/// profiler can tell how much the huffman, encoder and decoder classes allocate in every stage. Counting is off
+/// until enabled; the replaced operator new then costs two relaxed atomic additions.
+class allocation_counter {
+ public:
+  /// @brief Allocations made so far.
+  struct totals {
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+  };
+
+  /// @brief Starts counting.
+  static void enable();
+
+  /// @brief Called by operator new for every allocation.
+  /// @param size Number of bytes requested.
+  static void record(size_t size) noexcept {
+    if (!m_enabled.load(std::memory_order_relaxed)) return;
+    m_allocations.fetch_add(1, std::memory_order_relaxed);
+    m_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  /// @brief Returns the allocations counted since enable(), zeros if counting is off.
+  static totals get_totals();
+
+ private:
+  static std::atomic<bool> m_enabled;
+  static std::atomic<uint64_t> m_allocations;
+  static std::atomic<uint64_t> m_allocated_bytes;
+};
+
+#endif  // ALLOCATION_COUNTER_HPP
@@ -0,0 +1,94 @@
+#include "profiler.hpp"
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "allocation_counter.hpp"
+
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define STAGE_PROBE(probe, name) DTRACE_PROBE1(huffman, probe, name)
+#else
+#define STAGE_PROBE(probe, name)
+#endif
+
+namespace {
+
+struct event {
+  const char* name;
+  unsigned thread;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  uint64_t allocations;
+  uint64_t allocated_bytes;
+};
+
+std::atomic<bool> enabled{false};
+std::mutex events_mutex;
+std::vector<event> events;
+const auto origin = std::chrono::steady_clock::now();
+
+uint64_t now_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count());
+}
+
+// Small sequential thread numbers read better in trace viewers than hashed std::thread ids
+unsigned thread_number() {
+  static std::atomic<unsigned> next_thread{1};
+  thread_local const unsigned number = next_thread++;
+  return number;
+}
+
+}  // namespace
+
+profiler::stage::stage(const char* name)
+    : m_name(name), m_start_ns(0), m_start_allocations(0), m_start_allocated_bytes(0) {
+  STAGE_PROBE(stage_begin, m_name);
+  if (!is_enabled()) return;
+  const auto totals = allocation_counter::get_totals();
+  m_start_allocations = totals.allocations;
+  m_start_allocated_bytes = totals.allocated_bytes;
+  m_start_ns = now_ns();
+}
+
+profiler::stage::~stage() {
+  STAGE_PROBE(stage_end, m_name);
+  if (!is_enabled()) return;
+  const uint64_t end_ns = now_ns();
+  const auto totals = allocation_counter::get_totals();
+  const event finished{m_name,
+                       thread_number(),
+                       m_start_ns,
+                       end_ns - m_start_ns,
+                       totals.allocations - m_start_allocations,
+                       totals.allocated_bytes - m_start_allocated_bytes};
+  std::lock_guard<std::mutex> lock(events_mutex);
+  events.push_back(finished);
+}
+
+void profiler::enable() {
+  allocation_counter::enable();
+  enabled.store(true, std::memory_order_relaxed);
+}
+
+bool profiler::is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+void profiler::write_trace(std::ostream& out) {
+  std::lock_guard<std::mutex> lock(events_mutex);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (size_t i = 0; i < events.size(); ++i) {
+    const event& e = events[i];
+    // Complete ("X") events in microseconds; viewers nest them by time, which gives the flame chart
+    out << (i == 0 ? "\n" : ",\n")
+        << fmt::format("{{\"name\":\"{}\",\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},"
+                       "\"dur\":{:.3f},\"args\":{{\"allocations\":{},\"allocated_bytes\":{}}}}}",
+                       e.name, e.thread, static_cast<double>(e.start_ns) / 1000.0,
+                       static_cast<double>(e.duration_ns) / 1000.0, e.allocations, e.allocated_bytes);
+  }
+  out << "\n]}\n";
+}
@@ -0,0 +1,42 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+#include <cstdint>
+#include <ostream>
+
+/// @brief Marks the stages of a run (reading input, building the code, encoding, decoding, writing output) so that
+/// time and allocations can be attributed to them. Every stage fires the USDT probes huffman:stage_begin and
+/// huffman:stage_end (when built with <sys/sdt.h>), which perf and bpftrace can attach to at any time. When enabled,
+/// the profiler also records every stage with its duration and allocations and writes them as a Chrome trace.
+class profiler {
+ public:
+  /// @brief Scope of a stage, from construction to destruction. Stages may nest.
+  class stage {
+   public:
+    /// @brief Begins a stage.
+    /// @param name Static string naming the stage, e.g. "huffman::build_tree".
+    explicit stage(const char* name);
+    ~stage();
+    stage(const stage&) = delete;
+    stage& operator=(const stage&) = delete;
+
+   private:
+    const char* m_name;
+    uint64_t m_start_ns;
+    uint64_t m_start_allocations;
+    uint64_t m_start_allocated_bytes;
+  };
+
+  /// @brief Starts recording stages and counting allocations.
+  static void enable();
+
+  /// @brief Returns whether stages are recorded.
+  static bool is_enabled();
+
+  /// @brief Writes the recorded stages in the Chrome trace event format (chrome://tracing, Perfetto, speedscope):
+  /// one complete event per stage, with allocations and allocated bytes (of all threads, nested stages included) as
+  /// arguments.
+  /// @param out Destination stream.
+  static void write_trace(std::ostream& out);
+};
+
+#endif  // PROFILER_HPP